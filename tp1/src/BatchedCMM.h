@@ -0,0 +1,187 @@
+#ifndef BATCHEDCMM_H
+#define BATCHEDCMM_H
+
+#include "matrix.h"
+#include "TeamsData.h"
+
+#include <algorithm>
+#include <thread>
+
+//Resuelve muchos sistemas CMM chicos e independientes en una sola llamada.
+//Los torneos se ordenan por cantidad de equipos y se agrupan de a LANES; cada grupo se guarda
+//intercalado en un buffer contiguo (elemento (i,j) del torneo l en [(i*n + j)*LANES + l]),
+//de modo que la eliminacion avanza sobre los LANES sistemas a la vez y el loop interno vectoriza.
+//Los grupos se reparten entre todos los cores.
+class BatchedCMM {
+
+    public:
+        static const size_t LANES = 8;
+
+        //Devuelve, por cada torneo, el rating de cada equipo (con su numero original)
+        std::vector<std::map<int, double>> solve(const std::vector<std::vector<std::shared_ptr<Match>>> &tournaments) {
+            using namespace std;
+
+            //Reasignamos los numeros de equipo de cada torneo (sin modificar los partidos)
+            vector<vector<int>> asignedToOriginal(tournaments.size());
+            vector<vector<pair<size_t, size_t>>> localMatches(tournaments.size());
+            vector<vector<bool>> team1Wins(tournaments.size());
+            for(size_t t = 0; t < tournaments.size(); ++t) {
+                map<int, size_t> originalToAsigned;
+                for(auto &match : tournaments[t]) {
+                    size_t t1 = asignedIndex(match->team1, originalToAsigned, asignedToOriginal[t]);
+                    size_t t2 = asignedIndex(match->team2, originalToAsigned, asignedToOriginal[t]);
+                    localMatches[t].push_back({t1, t2});
+                    team1Wins[t].push_back(match->team1Goals > match->team2Goals);
+                }
+            }
+
+            //Ordenamos por tamaño para que cada grupo tenga poco relleno
+            vector<size_t> order(tournaments.size());
+            for(size_t t = 0; t < order.size(); ++t) {
+                order[t] = t;
+            }
+            stable_sort(order.begin(), order.end(), [&asignedToOriginal](size_t a, size_t b) {
+                return asignedToOriginal[a].size() < asignedToOriginal[b].size();
+            });
+
+            //Armamos los grupos y sus offsets dentro del buffer
+            vector<Batch> batches;
+            size_t matrixSize = 0;
+            size_t vectorSize = 0;
+            for(size_t first = 0; first < order.size(); first += LANES) {
+                Batch batch;
+                batch.first = first;
+                batch.count = order.size() - first < LANES ? order.size() - first : LANES;
+                batch.n = asignedToOriginal[order[first + batch.count - 1]].size();
+                batch.matrixOffset = matrixSize;
+                batch.vectorOffset = vectorSize;
+                matrixSize += batch.n * batch.n * LANES;
+                vectorSize += batch.n * LANES;
+                batches.push_back(batch);
+            }
+
+            vector<double> A(matrixSize, 0.0);
+            vector<double> b(vectorSize, 0.0);
+            vector<double> x(vectorSize, 0.0);
+
+            for(auto &batch : batches) {
+                double *Ab = A.data() + batch.matrixOffset;
+                double *bb = b.data() + batch.vectorOffset;
+                size_t n = batch.n;
+                for(size_t lane = 0; lane < LANES; ++lane) {
+                    //Los lugares sin torneo (o sin equipo) se rellenan con la identidad
+                    size_t teams = lane < batch.count ? asignedToOriginal[order[batch.first + lane]].size() : 0;
+                    for(size_t i = 0; i < n; ++i) {
+                        Ab[(i*n + i)*LANES + lane] = i < teams ? 2.0 : 1.0;
+                        bb[i*LANES + lane] = i < teams ? 1.0 : 0.0;
+                    }
+                    if(lane >= batch.count) {
+                        continue;
+                    }
+                    size_t t = order[batch.first + lane];
+                    for(size_t m = 0; m < localMatches[t].size(); ++m) {
+                        size_t t1 = localMatches[t][m].first;
+                        size_t t2 = localMatches[t][m].second;
+                        Ab[(t1*n + t1)*LANES + lane] += 1.0;
+                        Ab[(t2*n + t2)*LANES + lane] += 1.0;
+                        Ab[(t1*n + t2)*LANES + lane] -= 1.0;
+                        Ab[(t2*n + t1)*LANES + lane] -= 1.0;
+                        //Mismo criterio que TeamsData::insertMatch: el empate cuenta como victoria del equipo 2
+                        size_t winner = team1Wins[t][m] ? t1 : t2;
+                        size_t loser = winner == t1 ? t2 : t1;
+                        bb[winner*LANES + lane] += 0.5;
+                        bb[loser*LANES + lane] -= 0.5;
+                    }
+                }
+            }
+
+            //Repartimos los grupos entre los threads
+            size_t workers = max<size_t>(1, min<size_t>(thread::hardware_concurrency(), batches.size()));
+            vector<thread> threads;
+            for(size_t w = 0; w < workers; ++w) {
+                threads.push_back(thread([&, w]() {
+                    for(size_t i = w; i < batches.size(); i += workers) {
+                        const Batch &batch = batches[i];
+                        solveBatch(A.data() + batch.matrixOffset, b.data() + batch.vectorOffset,
+                                   x.data() + batch.vectorOffset, batch.n);
+                    }
+                }));
+            }
+            for(auto &th : threads) {
+                th.join();
+            }
+
+            //Devolvemos los ratings con los numeros de equipo originales
+            vector<map<int, double>> res(tournaments.size());
+            for(auto &batch : batches) {
+                for(size_t lane = 0; lane < batch.count; ++lane) {
+                    size_t t = order[batch.first + lane];
+                    for(size_t i = 0; i < asignedToOriginal[t].size(); ++i) {
+                        res[t][asignedToOriginal[t][i]] = x[batch.vectorOffset + i*LANES + lane];
+                    }
+                }
+            }
+            return res;
+        }
+
+    private:
+        struct Batch {
+            size_t first;
+            size_t count;
+            size_t n;
+            size_t matrixOffset;
+            size_t vectorOffset;
+        };
+
+        size_t asignedIndex(int team, std::map<int, size_t> &originalToAsigned, std::vector<int> &asignedToOriginal) {
+            auto it = originalToAsigned.find(team);
+            if(it != originalToAsigned.end()) {
+                return it->second;
+            }
+            originalToAsigned[team] = asignedToOriginal.size();
+            asignedToOriginal.push_back(team);
+            return asignedToOriginal.size() - 1;
+        }
+
+        //Eliminacion gaussiana y sustitucion hacia atras de LANES sistemas n x n intercalados
+        static void solveBatch(double *A, double *b, double *x, size_t n) {
+            double m[LANES];
+            for(size_t r1 = 0; r1 + 1 < n; ++r1) {
+                for(size_t r2 = r1 + 1; r2 < n; ++r2) {
+                    for(size_t lane = 0; lane < LANES; ++lane) {
+                        m[lane] = A[(r2*n + r1)*LANES + lane] / A[(r1*n + r1)*LANES + lane];
+                    }
+                    for(size_t c = r1 + 1; c < n; ++c) {
+                        double *dst = A + (r2*n + c)*LANES;
+                        const double *src = A + (r1*n + c)*LANES;
+                        for(size_t lane = 0; lane < LANES; ++lane) {
+                            dst[lane] -= src[lane]*m[lane];
+                        }
+                    }
+                    for(size_t lane = 0; lane < LANES; ++lane) {
+                        A[(r2*n + r1)*LANES + lane] = 0.0;
+                        b[r2*LANES + lane] -= b[r1*LANES + lane]*m[lane];
+                    }
+                }
+            }
+
+            double acc[LANES];
+            for(size_t row = n; row != 0; --row) {
+                for(size_t lane = 0; lane < LANES; ++lane) {
+                    acc[lane] = 0.0;
+                }
+                for(size_t c = row; c < n; ++c) {
+                    const double *a = A + ((row-1)*n + c)*LANES;
+                    for(size_t lane = 0; lane < LANES; ++lane) {
+                        acc[lane] += a[lane]*x[c*LANES + lane];
+                    }
+                }
+                const double *diag = A + ((row-1)*n + row-1)*LANES;
+                for(size_t lane = 0; lane < LANES; ++lane) {
+                    x[(row-1)*LANES + lane] = (b[(row-1)*LANES + lane] - acc[lane])/diag[lane];
+                }
+            }
+        }
+};
+
+#endif //BATCHEDCMM_H
@@ -2,13 +2,39 @@
 #define CMM_H
 
 #include "RankingCalculator.h"
+#include "MatchGraph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <type_traits>
 
 class CMM : public RankingCalculator {
 
     public:
+        //Sistemas de hasta esta cantidad de equipos se resuelven con matrices de tamaño fijo (en el stack)
+        static const size_t SMALL_SYSTEM_MAX = 32;
+
         std::shared_ptr<SparceMatrix> generateRanking(std::shared_ptr<TeamsData> data) {
+            //Si el grafo de partidos no es conexo el sistema es diagonal por bloques:
+            //resolvemos cada componente por separado
+            std::vector<std::vector<int>> components = MatchGraph(*data).components();
+            if(components.size() > 1){
+                return generateRankingByComponents(*data, components);
+            }
+
+            return generateConnectedRanking(data);
+        }
+
+    private:
+        std::shared_ptr<SparceMatrix> generateConnectedRanking(std::shared_ptr<TeamsData> data) {
             using namespace std;
 
+            shared_ptr<SparceMatrix> small;
+            if(generateSmallRanking(*data, small, integral_constant<size_t, SMALL_SYSTEM_MAX>())){
+                return small;
+            }
+
             auto cmm_b = buildCMM_b(*data);
             auto copyCmm = *cmm_b.first;
             auto copyB = *cmm_b.second;
@@ -20,7 +46,63 @@ class CMM : public RankingCalculator {
             return res;
         }
 
-    private:
+        std::shared_ptr<SparceMatrix> generateRankingByComponents(const TeamsData &data, const std::vector<std::vector<int>> &components) {
+            using namespace std;
+
+            //Armamos el sub-sistema de cada componente renumerando sus equipos de 1..k (en el mismo orden relativo)
+            vector<size_t> componentOf(data.teams().size());
+            vector<int> localIndex(data.teams().size());
+            vector<shared_ptr<TeamsData>> componentsData;
+            for(size_t c = 0; c < components.size(); ++c){
+                for(size_t i = 0; i < components[c].size(); ++i){
+                    componentOf[components[c][i]-1] = c;
+                    localIndex[components[c][i]-1] = i+1;
+                }
+                componentsData.push_back(shared_ptr<TeamsData>(new TeamsData(components[c].size())));
+            }
+            for(auto &match : data.getMatches()){
+                Match local = *match;
+                local.team1 = localIndex[match->team1-1];
+                local.team2 = localIndex[match->team2-1];
+                componentsData[componentOf[match->team1-1]]->insertMatch(local);
+            }
+
+            //Las componentes mas grandes se reparten primero entre los threads
+            vector<size_t> order(components.size());
+            for(size_t c = 0; c < order.size(); ++c){
+                order[c] = c;
+            }
+            sort(order.begin(), order.end(), [&components](size_t a, size_t b){
+                return components[a].size() > components[b].size();
+            });
+
+            vector<shared_ptr<SparceMatrix>> componentsRanking(components.size());
+            atomic<size_t> next(0);
+            auto worker = [&](){
+                for(size_t i = next++; i < order.size(); i = next++){
+                    componentsRanking[order[i]] = generateConnectedRanking(componentsData[order[i]]);
+                }
+            };
+            size_t workers = min<size_t>(thread::hardware_concurrency(), components.size());
+            vector<thread> threads;
+            for(size_t w = 1; w < workers; ++w){
+                threads.push_back(thread(worker));
+            }
+            worker();
+            for(auto &th : threads){
+                th.join();
+            }
+
+            //Volvemos a la numeracion original
+            shared_ptr<SparceMatrix> ret(new SparceMatrix(data.teams().size(), 1));
+            for(size_t c = 0; c < components.size(); ++c){
+                for(size_t i = 0; i < components[c].size(); ++i){
+                    ret->insertValueAtRowColumn(componentsRanking[c]->retrieveAt(i, 0), components[c][i]-1, 0);
+                }
+            }
+            return ret;
+        }
+
         std::pair<std::shared_ptr<SparceMatrix>,std::shared_ptr<SparceMatrix>> buildCMM_b(const TeamsData &data) {
             using namespace std;
             const set<int> &teams = data.teams();
@@ -80,6 +162,89 @@ class CMM : public RankingCalculator {
             return ret;
         }
 
+        //Busca el N que coincide con la cantidad de equipos y resuelve con FixedMatrix<N,N>
+        //Devuelve false si el sistema es mas grande que SMALL_SYSTEM_MAX
+        template<size_t N>
+        bool generateSmallRanking(const TeamsData &data, std::shared_ptr<SparceMatrix> &res, std::integral_constant<size_t, N>) {
+            if(data.teams().size() == N){
+                res = generateFixedRanking<N>(data);
+                return true;
+            }
+            return generateSmallRanking(data, res, std::integral_constant<size_t, N-1>());
+        }
+
+        bool generateSmallRanking(const TeamsData &, std::shared_ptr<SparceMatrix> &, std::integral_constant<size_t, 0>) {
+            return false;
+        }
+
+        template<size_t N>
+        std::shared_ptr<SparceMatrix> generateFixedRanking(const TeamsData &data) {
+            FixedMatrix<N,N> cmm;
+            FixedMatrix<N,1> b;
+
+            //Armamos el sistema recorriendo los partidos una sola vez
+            for(size_t t = 0; t < N; ++t){
+                cmm.at(t,t) = 2.0;
+                b.at(t,0) = 1.0;
+            }
+            for(auto &match : data.getMatches()){
+                size_t t1 = match->team1-1;
+                size_t t2 = match->team2-1;
+                cmm.at(t1,t1) += 1.0;
+                cmm.at(t2,t2) += 1.0;
+                cmm.at(t1,t2) -= 1.0;
+                cmm.at(t2,t1) -= 1.0;
+                //Mismo criterio que TeamsData::insertMatch: el empate cuenta como victoria del equipo 2
+                size_t winner = match->team1Goals > match->team2Goals ? t1 : t2;
+                size_t loser = winner == t1 ? t2 : t1;
+                b.at(winner,0) += 0.5;
+                b.at(loser,0) -= 0.5;
+            }
+
+            gaussian(cmm, b);
+
+            FixedMatrix<N,1> x = solve(cmm, b);
+
+            std::shared_ptr<SparceMatrix> ret(new SparceMatrix(N, 1));
+            for(size_t t = 0; t < N; ++t){
+                ret->insertValueAtRowColumn(x.at(t,0), t, 0);
+            }
+            return ret;
+        }
+
+        template<size_t N>
+        void gaussian(FixedMatrix<N,N> &M, FixedMatrix<N,1> &b){
+            for(size_t r1 = 0; r1 + 1 < N; ++r1){
+                double v1 = M.at(r1,r1);
+                for(size_t r2 = r1 + 1; r2 < N; ++r2){
+                    double m = M.at(r2,r1)/v1;
+                    if(m == 0.0){
+                        continue;
+                    }
+                    for(size_t c = r1 + 1; c < N; ++c){
+                        M.at(r2,c) -= M.at(r1,c)*m;
+                    }
+                    M.at(r2,r1) = 0.0;
+                    b.at(r2,0) -= b.at(r1,0)*m;
+                }
+            }
+        }
+
+        template<size_t N>
+        FixedMatrix<N,1> solve(const FixedMatrix<N,N> &M, const FixedMatrix<N,1> &b) {
+            FixedMatrix<N,1> x;
+
+            for(size_t row = N; row != 0; --row){
+                double toSubtract = 0.0;
+                for(size_t c = row; c < N; ++c){
+                    toSubtract += M.at(row-1,c)*x.at(c,0);
+                }
+                x.at(row-1,0) = (b.at(row-1,0) - toSubtract)/M.at(row-1,row-1);
+            }
+
+            return x;
+        }
+
 };
 
 #endif //CMM_H
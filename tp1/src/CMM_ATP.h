@@ -3,17 +3,13 @@
 
 #include "RankingCalculator.h"
 #include "CMM.h"
+#include "BatchedCMM.h"
 
 class CMM_ATP : public RankingCalculator {
 
     public:
         std::shared_ptr<SparceMatrix> generateRanking(std::shared_ptr<TeamsData> data) {
-            //Guardamos cada match en su fecha
-            //Interpretamos cada fecha como un torneo
-            std::map<int, std::vector<std::shared_ptr<Match>>> matchesByDate;
-            for (auto match : data->getMatches()) {
-                matchesByDate[match->date].push_back(match);
-            }
+            std::map<int, std::vector<std::shared_ptr<Match>>> matchesByDate = groupByDate(*data);
 
             //Separamos los torneos por categorias
             //Las categorias las determinamos por la cantidad de partidos que componen el torneo
@@ -46,8 +42,39 @@ class CMM_ATP : public RankingCalculator {
             return rating;
         }
 
+        //Calcula el rating CMM de cada torneo (fecha) por separado, resolviendo todos juntos en un BatchedCMM
+        //Devuelve por cada fecha el rating de los equipos que jugaron en ella
+        std::map<int, std::map<int, double>> generateTournamentRankings(std::shared_ptr<TeamsData> data) {
+            std::map<int, std::vector<std::shared_ptr<Match>>> matchesByDate = groupByDate(*data);
+
+            std::vector<int> dates;
+            std::vector<std::vector<std::shared_ptr<Match>>> tournaments;
+            for (auto &tournament : matchesByDate) {
+                dates.push_back(tournament.first);
+                tournaments.push_back(tournament.second);
+            }
+
+            std::vector<std::map<int, double>> scores = BatchedCMM().solve(tournaments);
+
+            std::map<int, std::map<int, double>> res;
+            for (size_t i = 0; i < dates.size(); ++i) {
+                res[dates[i]] = scores[i];
+            }
+            return res;
+        }
+
 
     private:
+        //Guardamos cada match en su fecha
+        //Interpretamos cada fecha como un torneo
+        std::map<int, std::vector<std::shared_ptr<Match>>> groupByDate(const TeamsData &data) {
+            std::map<int, std::vector<std::shared_ptr<Match>>> matchesByDate;
+            for (auto match : data.getMatches()) {
+                matchesByDate[match->date].push_back(match);
+            }
+            return matchesByDate;
+        }
+
         std::map<int, double> getTournamentScore(std::vector<std::shared_ptr<Match>> &tournament) {
             std::map<int, double> res;
 
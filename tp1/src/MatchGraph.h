@@ -0,0 +1,65 @@
+#ifndef MATCHGRAPH_H
+#define MATCHGRAPH_H
+
+#include "matrix.h"
+#include "TeamsData.h"
+
+#include <numeric>
+
+//Grafo de partidos: los equipos son nodos y cada partido una arista.
+//Calcula las componentes conexas con union-find (union por tamaño y compresion de caminos).
+class MatchGraph {
+
+    public:
+        MatchGraph(const TeamsData &data):
+            _parent(data.teams().size()),
+            _size(data.teams().size(), 1) {
+            std::iota(_parent.begin(), _parent.end(), 0);
+            for(auto &match : data.getMatches()) {
+                unite(match->team1-1, match->team2-1);
+            }
+        }
+
+        //Devuelve los equipos de cada componente, en orden creciente dentro de cada una.
+        //Las componentes se ordenan por su menor equipo.
+        std::vector<std::vector<int>> components() {
+            std::vector<std::vector<int>> res;
+            std::vector<size_t> componentOfRoot(_parent.size(), _parent.size());
+            for(size_t t = 0; t < _parent.size(); ++t) {
+                size_t root = find(t);
+                if(componentOfRoot[root] == _parent.size()) {
+                    componentOfRoot[root] = res.size();
+                    res.push_back(std::vector<int>());
+                }
+                res[componentOfRoot[root]].push_back(t+1);
+            }
+            return res;
+        }
+
+    private:
+        size_t find(size_t t) {
+            while(_parent[t] != t) {
+                _parent[t] = _parent[_parent[t]];
+                t = _parent[t];
+            }
+            return t;
+        }
+
+        void unite(size_t t1, size_t t2) {
+            size_t r1 = find(t1);
+            size_t r2 = find(t2);
+            if(r1 == r2) {
+                return;
+            }
+            if(_size[r1] < _size[r2]) {
+                std::swap(r1, r2);
+            }
+            _parent[r2] = r1;
+            _size[r1] += _size[r2];
+        }
+
+        std::vector<size_t> _parent;
+        std::vector<size_t> _size;
+};
+
+#endif //MATCHGRAPH_H
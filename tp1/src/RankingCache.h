@@ -0,0 +1,160 @@
+#ifndef RANKINGCACHE_H
+#define RANKINGCACHE_H
+
+#include "matrix.h"
+#include "TeamsData.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+//Cache en disco de rankings ya calculados.
+//La clave es un hash del contenido de la entrada (equipos y partidos, en orden) y del metodo.
+//Cada entrada es un archivo '<clave>.rank' con el formato binario:
+//    magic "TPRC" | version (uint32) | clave (uint64) | filas (uint64) | filas * double | checksum (uint64)
+//El checksum se calcula sobre todo lo anterior; si no coincide la entrada se ignora.
+//Las entradas se escriben en un archivo temporal unico y despues se renombran, de forma que
+//varias corridas en paralelo nunca ven un archivo a medio escribir.
+class RankingCache {
+
+    public:
+        RankingCache(const std::string &directory): _directory(directory) {
+        }
+
+        static uint64_t hash(const TeamsData &data, int method) {
+            uint64_t h = FNV_OFFSET;
+            h = mix(h, VERSION);
+            h = mix(h, (uint64_t)method);
+            h = mix(h, data.teams().size());
+            for(auto &match : data.getMatches()) {
+                h = mix(h, (uint64_t)(uint32_t)match->date);
+                h = mix(h, (uint64_t)(uint32_t)match->team1);
+                h = mix(h, (uint64_t)(uint32_t)match->team1Goals);
+                h = mix(h, (uint64_t)(uint32_t)match->team2);
+                h = mix(h, (uint64_t)(uint32_t)match->team2Goals);
+            }
+            return h;
+        }
+
+        //Devuelve el ranking guardado para 'key', o nullptr si no esta o la entrada es invalida
+        std::shared_ptr<SparceMatrix> load(uint64_t key) const {
+            using namespace std;
+            ifstream file(entryPath(key), ios::binary);
+            if(!file.good()) {
+                return nullptr;
+            }
+            string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+            size_t header = 4 + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+            if(content.size() < header + sizeof(uint64_t) || content.compare(0, 4, magic()) != 0) {
+                return nullptr;
+            }
+            uint32_t version;
+            uint64_t storedKey, rows, checksum;
+            memcpy(&version, &content[4], sizeof(version));
+            memcpy(&storedKey, &content[4 + sizeof(uint32_t)], sizeof(storedKey));
+            memcpy(&rows, &content[4 + sizeof(uint32_t) + sizeof(uint64_t)], sizeof(rows));
+            if(version != VERSION || storedKey != key || rows > content.size() || content.size() != header + rows * sizeof(double) + sizeof(uint64_t)) {
+                return nullptr;
+            }
+            size_t payload = content.size() - sizeof(uint64_t);
+            memcpy(&checksum, &content[payload], sizeof(checksum));
+            if(checksum != bytesHash(content.data(), payload)) {
+                return nullptr;
+            }
+
+            shared_ptr<SparceMatrix> ranking(new SparceMatrix(rows, 1));
+            for(size_t r = 0; r < rows; ++r) {
+                double value;
+                memcpy(&value, &content[header + r * sizeof(double)], sizeof(value));
+                ranking->insertValueAtRowColumn(value, r, 0);
+            }
+            return ranking;
+        }
+
+        //Guarda el ranking para 'key'. Si no se puede escribir, la cache simplemente no se actualiza
+        void store(uint64_t key, const SparceMatrix &ranking) const {
+            using namespace std;
+            string content(magic(), 4);
+            uint32_t version = VERSION;
+            uint64_t rows = ranking.rows();
+            append(content, &version, sizeof(version));
+            append(content, &key, sizeof(key));
+            append(content, &rows, sizeof(rows));
+            for(size_t r = 0; r < rows; ++r) {
+                double value = ranking.retrieveAt(r, 0);
+                append(content, &value, sizeof(value));
+            }
+            uint64_t checksum = bytesHash(content.data(), content.size());
+            append(content, &checksum, sizeof(checksum));
+
+            string path = entryPath(key);
+            string tmpPath = path + ".tmp" + uniqueSuffix();
+            {
+                ofstream file(tmpPath, ios::binary | ios::trunc);
+                if(!file.good()) {
+                    return;
+                }
+                file.write(content.data(), content.size());
+                if(!file.good()) {
+                    file.close();
+                    remove(tmpPath.c_str());
+                    return;
+                }
+            }
+            if(rename(tmpPath.c_str(), path.c_str()) != 0) {
+                remove(tmpPath.c_str());
+            }
+        }
+
+        std::string entryPath(uint64_t key) const {
+            std::ostringstream path;
+            path << _directory << "/" << std::hex << key << ".rank";
+            return path.str();
+        }
+
+    private:
+        static const uint32_t VERSION = 1;
+        static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+        static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+        static const char* magic() {
+            return "TPRC";
+        }
+
+        //FNV-1a sobre palabras de 64 bits
+        static uint64_t mix(uint64_t h, uint64_t value) {
+            return (h ^ value) * FNV_PRIME;
+        }
+
+        static uint64_t bytesHash(const char *data, size_t size) {
+            uint64_t h = FNV_OFFSET;
+            for(size_t i = 0; i < size; ++i) {
+                h = (h ^ (unsigned char)data[i]) * FNV_PRIME;
+            }
+            return h;
+        }
+
+        static void append(std::string &content, const void *value, size_t size) {
+            content.append((const char *)value, size);
+        }
+
+        static std::string uniqueSuffix() {
+            std::ostringstream suffix;
+            suffix << "." << std::random_device()()
+                   << "." << std::hash<std::thread::id>()(std::this_thread::get_id())
+                   << "." << std::chrono::high_resolution_clock::now().time_since_epoch().count();
+            return suffix.str();
+        }
+
+        std::string _directory;
+};
+
+#endif //RANKINGCACHE_H
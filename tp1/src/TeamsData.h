@@ -43,7 +43,7 @@ class TeamsData{
             return _teams;
         }
 
-        const std::vector<std::shared_ptr<Match>> getMatches() const {
+        const std::vector<std::shared_ptr<Match>>& getMatches() const {
             return _matches;
         }
 
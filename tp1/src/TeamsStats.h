@@ -0,0 +1,145 @@
+#ifndef TEAMSSTATS_H
+#define TEAMSSTATS_H
+
+#include "matrix.h"
+#include "TeamsData.h"
+
+#include <thread>
+
+//Estadisticas agregadas por equipo calculadas en una sola pasada sobre los partidos.
+//Los partidos se reparten en bloques entre los threads, cada thread acumula en su propia copia
+//y al final se suman. Todos los arreglos se indexan por (equipo - 1).
+//Se considera local al team1 y visitante al team2 de cada partido.
+class TeamsStats {
+
+    public:
+        //Por debajo de esta cantidad de partidos por thread no conviene lanzar threads
+        static const size_t MIN_MATCHES_PER_THREAD = 4096;
+
+        TeamsStats(const TeamsData &data):
+            TeamsStats(data.teams().size()) {
+            using namespace std;
+            const vector<shared_ptr<Match>> &matches = data.getMatches();
+
+            size_t workers = min<size_t>(thread::hardware_concurrency(), matches.size() / MIN_MATCHES_PER_THREAD);
+            if(workers <= 1) {
+                accumulate(matches, 0, matches.size());
+                return;
+            }
+
+            vector<TeamsStats> partials(workers, TeamsStats(_wins.size()));
+            vector<thread> threads;
+            size_t chunk = (matches.size() + workers - 1) / workers;
+            for(size_t w = 0; w < workers; ++w) {
+                size_t begin = min(w * chunk, matches.size());
+                size_t end = min(begin + chunk, matches.size());
+                threads.push_back(thread([&partials, &matches, w, begin, end]() {
+                    partials[w].accumulate(matches, begin, end);
+                }));
+            }
+            for(auto &th : threads) {
+                th.join();
+            }
+
+            for(auto &partial : partials) {
+                merge(partial);
+            }
+        }
+
+        const std::vector<size_t>& wins() const { return _wins; }
+        const std::vector<size_t>& loses() const { return _loses; }
+        const std::vector<size_t>& matchesPlayed() const { return _played; }
+        const std::vector<long>& goalsFor() const { return _goalsFor; }
+        const std::vector<long>& goalsAgainst() const { return _goalsAgainst; }
+        const std::vector<size_t>& homeWins() const { return _homeWins; }
+        const std::vector<size_t>& homeMatchesPlayed() const { return _homePlayed; }
+        const std::vector<size_t>& awayWins() const { return _awayWins; }
+        const std::vector<size_t>& awayMatchesPlayed() const { return _awayPlayed; }
+
+        long goalDifferential(int team) const {
+            return _goalsFor[team-1] - _goalsAgainst[team-1];
+        }
+
+        //Cantidad de veces que team1 le gano a team2
+        size_t winsAgainst(int team1, int team2) const {
+            return _headToHeadWins.retrieveAt(team1-1, team2-1);
+        }
+
+        //Tabla completa de enfrentamientos: en (i, j) las victorias del equipo i+1 sobre el equipo j+1
+        const Matrix<size_t, std::map<size_t,size_t>>& headToHead() const {
+            return _headToHeadWins;
+        }
+
+    private:
+        TeamsStats(size_t teamsCount):
+            _wins(teamsCount, 0),
+            _loses(teamsCount, 0),
+            _played(teamsCount, 0),
+            _goalsFor(teamsCount, 0),
+            _goalsAgainst(teamsCount, 0),
+            _homeWins(teamsCount, 0),
+            _homePlayed(teamsCount, 0),
+            _awayWins(teamsCount, 0),
+            _awayPlayed(teamsCount, 0),
+            _headToHeadWins(teamsCount, teamsCount) {
+        }
+
+        void accumulate(const std::vector<std::shared_ptr<Match>> &matches, size_t begin, size_t end) {
+            for(size_t i = begin; i < end; ++i) {
+                const Match &match = *matches[i];
+                size_t home = match.team1-1;
+                size_t away = match.team2-1;
+
+                _played[home]++;
+                _played[away]++;
+                _homePlayed[home]++;
+                _awayPlayed[away]++;
+                _goalsFor[home] += match.team1Goals;
+                _goalsAgainst[home] += match.team2Goals;
+                _goalsFor[away] += match.team2Goals;
+                _goalsAgainst[away] += match.team1Goals;
+
+                //Mismo criterio que TeamsData::insertMatch: el empate cuenta como victoria del equipo 2
+                if(match.team1Goals > match.team2Goals) {
+                    _wins[home]++;
+                    _loses[away]++;
+                    _homeWins[home]++;
+                    _headToHeadWins.at(home, away)++;
+                }
+                else {
+                    _wins[away]++;
+                    _loses[home]++;
+                    _awayWins[away]++;
+                    _headToHeadWins.at(away, home)++;
+                }
+            }
+        }
+
+        void merge(const TeamsStats &oth) {
+            for(size_t t = 0; t < _wins.size(); ++t) {
+                _wins[t] += oth._wins[t];
+                _loses[t] += oth._loses[t];
+                _played[t] += oth._played[t];
+                _goalsFor[t] += oth._goalsFor[t];
+                _goalsAgainst[t] += oth._goalsAgainst[t];
+                _homeWins[t] += oth._homeWins[t];
+                _homePlayed[t] += oth._homePlayed[t];
+                _awayWins[t] += oth._awayWins[t];
+                _awayPlayed[t] += oth._awayPlayed[t];
+            }
+            _headToHeadWins += oth._headToHeadWins;
+        }
+
+        std::vector<size_t> _wins;
+        std::vector<size_t> _loses;
+        std::vector<size_t> _played;
+        std::vector<long> _goalsFor;
+        std::vector<long> _goalsAgainst;
+        std::vector<size_t> _homeWins;
+        std::vector<size_t> _homePlayed;
+        std::vector<size_t> _awayWins;
+        std::vector<size_t> _awayPlayed;
+        Matrix<size_t, std::map<size_t,size_t>> _headToHeadWins;
+};
+
+#endif //TEAMSSTATS_H
@@ -2,16 +2,21 @@
 #define WP_H
 
 #include "RankingCalculator.h"
+#include "TeamsStats.h"
 
 class WP : public RankingCalculator {
 
     public:
         std::shared_ptr <SparceMatrix> generateRanking(std::shared_ptr <TeamsData> data) {
             using namespace std;
-            std::shared_ptr<SparceMatrix> wp(new SparceMatrix(data->teams().size(), 1));
-            for (auto t : data->teams()) {
-                double percentage = (double)(data->numberOfWins(t))/(double)(data->numberOfMatchesPlayed(t));
-                wp->insertValueAtRowColumn(percentage, t-1, 0);
+            TeamsStats stats(*data);
+            const vector<size_t> &wins = stats.wins();
+            const vector<size_t> &played = stats.matchesPlayed();
+
+            std::shared_ptr<SparceMatrix> wp(new SparceMatrix(wins.size(), 1));
+            for (size_t t = 0; t < wins.size(); ++t) {
+                double percentage = (double)(wins[t])/(double)(played[t]);
+                wp->insertValueAtRowColumn(percentage, t, 0);
             }
 
             return wp;
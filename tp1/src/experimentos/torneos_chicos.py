@@ -0,0 +1,75 @@
+import os
+import random
+import subprocess as sp
+import sys
+import time
+
+#Benchmark de muchos torneos chicos (6-10 equipos, como los tests de la catedra)
+#Cada torneo se escribe en su propio archivo y se rankea con CMM; ademas se juntan todos en un unico
+#archivo (un torneo por fecha) que se rankea de una sola vez con CMM por torneo (metodo 3)
+#Uso: python torneos_chicos.py [cantidad_torneos] [jugadores_por_torneo]
+
+def generarTorneo(path, jugadores):
+    #Llave de eliminacion directa mas un partido de ida y vuelta entre vecinos
+    ronda = random.sample(range(1, jugadores + 1), jugadores)
+    partidos = []
+    for i in range(jugadores):
+        a, b = ronda[i], ronda[(i + 1) % jugadores]
+        partidos.append('1 {} {} {} {}'.format(a, random.randint(0, 5), b, random.randint(0, 5)))
+    while len(ronda) > 1:
+        siguiente = []
+        for i in range(0, len(ronda) - 1, 2):
+            a, b = ronda[i], ronda[i + 1]
+            if random.random() < 0.5:
+                a, b = b, a
+            partidos.append('2 {} 1 {} 0'.format(a, b))
+            siguiente.append(a)
+        if len(ronda) % 2 == 1:
+            siguiente.append(ronda[-1])
+        ronda = siguiente
+
+    with open(path, 'w') as f:
+        f.write('{} {}\n'.format(jugadores, len(partidos)))
+        f.write('\n'.join(partidos) + '\n')
+
+if __name__ == '__main__':
+    torneos = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+    jugadores = int(sys.argv[2]) if len(sys.argv) > 2 else 8
+
+    random.seed(0)
+    directorio = 'torneos_chicos'
+    if not os.path.exists(directorio):
+        os.makedirs(directorio)
+
+    entradas = []
+    for t in range(torneos):
+        entrada = os.path.join(directorio, 'torneo_{}.in'.format(t))
+        generarTorneo(entrada, jugadores)
+        entradas.append(entrada)
+
+    inicio = time.time()
+    for entrada in entradas:
+        sp.check_call(['../tp', entrada, entrada.replace('.in', '.out'), '0'], stdout=sp.DEVNULL)
+    total = time.time() - inicio
+
+    #El tiempo incluye el lanzamiento del proceso, que domina para sistemas de este tamaño
+    print('CMM: {} torneos de {} jugadores en {:.3f}s ({:.1f} us/torneo)'.format(torneos, jugadores, total, total * 1e6 / torneos))
+
+    #Todos los torneos en un unico archivo, cada uno en su fecha y con sus propios equipos
+    partidos = []
+    for t, entrada in enumerate(entradas):
+        with open(entrada) as f:
+            next(f)
+            for linea in f:
+                _, a, ga, b, gb = linea.split()
+                partidos.append('{} {} {} {} {}'.format(t + 1, int(a) + t * jugadores, ga, int(b) + t * jugadores, gb))
+    unico = os.path.join(directorio, 'todos.in')
+    with open(unico, 'w') as f:
+        f.write('{} {}\n'.format(torneos * jugadores, len(partidos)))
+        f.write('\n'.join(partidos) + '\n')
+
+    inicio = time.time()
+    sp.check_call(['../tp', unico, unico.replace('.in', '.out'), '3'], stdout=sp.DEVNULL)
+    total = time.time() - inicio
+
+    print('CMM por torneo: {} torneos de {} jugadores en {:.3f}s ({:.1f} us/torneo)'.format(torneos, jugadores, total, total * 1e6 / torneos))
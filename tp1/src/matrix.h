@@ -352,6 +352,78 @@ private:
     std::unique_ptr<Container*[]> _mat;
 };
 
+/* ----- MATRIX SPECIALIZATION (fixed size) ----- */
+
+// Tag used as Container to select the fixed size specialization of Matrix.
+// The dimensions are known at compile time and the elements are stored inline,
+// so no heap allocation is done. Intended for small systems (a few dozens rows).
+template<size_t RowsN, size_t ColumnsN>
+struct FixedSize{};
+
+template<typename T, size_t RowsN, size_t ColumnsN>
+class Matrix<T, FixedSize<RowsN, ColumnsN>>{
+public:
+    // creates a matrix with every element set to T().
+    Matrix(){
+        for(size_t row = 0; row < RowsN; ++row){
+            for(size_t column = 0; column < ColumnsN; ++column){
+                _mat[row][column] = T();
+            }
+        }
+    }
+
+    Matrix(std::initializer_list<std::initializer_list<T>>);
+
+    /* ----- DIMENTIONS ----- */
+
+    //gets total size.
+    constexpr size_t size() const{
+        return RowsN*ColumnsN;
+    }
+
+    //gets number of rows.
+    constexpr size_t rows() const{
+        return RowsN;
+    }
+
+    //gets number of columns.
+    constexpr size_t columns() const{
+        return ColumnsN;
+    }
+
+    /* ----- GETTERS & SETTERS ----- */
+
+    // returns a reference to the element in row 'row', column 'column'.
+    T& at(size_t row, size_t column){
+        return _mat[row][column];
+    }
+
+    const T& at(size_t row, size_t column) const{
+        return _mat[row][column];
+    }
+
+    // returns a copy of the element in row 'row', column 'column'.
+    T retrieveAt(size_t row, size_t column) const{
+        return _mat[row][column];
+    }
+
+    void insertValueAtRowColumn(const T& value, size_t row, size_t column){
+        _mat[row][column] = value;
+    }
+
+    /* ----- OPERATORS ----- */
+
+    Matrix<T, FixedSize<RowsN, ColumnsN>>& operator+=(const Matrix<T, FixedSize<RowsN, ColumnsN>>&);
+    Matrix<T, FixedSize<RowsN, ColumnsN>>& operator-=(const Matrix<T, FixedSize<RowsN, ColumnsN>>&);
+    Matrix<T, FixedSize<RowsN, ColumnsN>>& operator*=(const T&);
+    Matrix<T, FixedSize<RowsN, ColumnsN>>& operator/=(const T&);
+
+private:
+    /* ----- MEMBERS ----- */
+
+    T _mat[RowsN][ColumnsN];
+};
+
 /* ----- ROWITERATOR (array) ----- */
 
 template<typename T>
@@ -966,6 +1038,66 @@ Matrix<T, Container*>& Matrix<T, Container*>::operator/=(const T &scalar){
     return *this;
 }
 
+/* ----- MATRIX (fixed size) DEFINITIONS ----- */
+
+template<typename T, size_t RowsN, size_t ColumnsN>
+Matrix<T, FixedSize<RowsN, ColumnsN>>::Matrix(std::initializer_list<std::initializer_list<T>> il):
+    Matrix(){
+    size_t row = 0;
+    for(auto rowIt = il.begin(); rowIt != il.end() && row < RowsN; ++rowIt){
+        size_t column = 0;
+        for(auto columnIt = rowIt->begin(); columnIt != rowIt->end() && column < ColumnsN; ++columnIt){
+            _mat[row][column] = *columnIt;
+            ++column;
+        }
+        ++row;
+    }
+}
+
+template<typename T, size_t RowsN, size_t ColumnsN>
+Matrix<T, FixedSize<RowsN, ColumnsN>>& Matrix<T, FixedSize<RowsN, ColumnsN>>::operator+=(const Matrix<T, FixedSize<RowsN, ColumnsN>> &m2){
+    for(size_t row = 0; row < RowsN; ++row){
+        for(size_t column = 0; column < ColumnsN; ++column){
+            _mat[row][column] += m2._mat[row][column];
+        }
+    }
+
+    return *this;
+}
+
+template<typename T, size_t RowsN, size_t ColumnsN>
+Matrix<T, FixedSize<RowsN, ColumnsN>>& Matrix<T, FixedSize<RowsN, ColumnsN>>::operator-=(const Matrix<T, FixedSize<RowsN, ColumnsN>> &m2){
+    for(size_t row = 0; row < RowsN; ++row){
+        for(size_t column = 0; column < ColumnsN; ++column){
+            _mat[row][column] -= m2._mat[row][column];
+        }
+    }
+
+    return *this;
+}
+
+template<typename T, size_t RowsN, size_t ColumnsN>
+Matrix<T, FixedSize<RowsN, ColumnsN>>& Matrix<T, FixedSize<RowsN, ColumnsN>>::operator*=(const T &scalar){
+    for(size_t row = 0; row < RowsN; ++row){
+        for(size_t column = 0; column < ColumnsN; ++column){
+            _mat[row][column] *= scalar;
+        }
+    }
+
+    return *this;
+}
+
+template<typename T, size_t RowsN, size_t ColumnsN>
+Matrix<T, FixedSize<RowsN, ColumnsN>>& Matrix<T, FixedSize<RowsN, ColumnsN>>::operator/=(const T &scalar){
+    for(size_t row = 0; row < RowsN; ++row){
+        for(size_t column = 0; column < ColumnsN; ++column){
+            _mat[row][column] /= scalar;
+        }
+    }
+
+    return *this;
+}
+
 /* ----- FUNCTIONS ----- */
 
 template<typename T, typename Container>
@@ -1138,5 +1270,7 @@ T dot(const Matrix<T, Container1> &v1, const Matrix<T, Container2> &v2){
 
 using DenseMatrix = Matrix<double>;
 using SparceMatrix = Matrix<double, std::map<size_t, double>>;
+template<size_t RowsN, size_t ColumnsN>
+using FixedMatrix = Matrix<double, FixedSize<RowsN, ColumnsN>>;
 
 #endif
\ No newline at end of file
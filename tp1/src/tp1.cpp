@@ -4,6 +4,7 @@
 #include "CMM.h"
 #include "WP.h"
 #include "CMM_ATP.h"
+#include "RankingCache.h"
 
 #include <iostream>
 #include <fstream>
@@ -16,6 +17,7 @@
 void showHelp();
 void readInput(const std::string &inFileName, std::shared_ptr<TeamsData> &outData);
 void writeOutput(const std::string &outFileName, const SparceMatrix &ranking);
+void writeTournamentsOutput(const std::string &outFileName, const std::map<int, std::map<int, double>> &rankings);
 
 int main(int argc, char** argv){
     using namespace std;
@@ -36,6 +38,14 @@ int main(int argc, char** argv){
 
     cout << "Running method..." << endl;
 
+    //CMM por torneo: la salida tiene un rating por cada fecha y equipo
+    if(method == 3) {
+        auto rankings = CMM_ATP().generateTournamentRankings(data);
+        cout << "Writing " << outFile << "... " << endl;
+        writeTournamentsOutput(outFile, rankings);
+        return 0;
+    }
+
     std::shared_ptr<RankingCalculator> rankingCalculator;
 
     switch(method) {
@@ -57,7 +67,23 @@ int main(int argc, char** argv){
             return 1;
     }
 
-    std::shared_ptr<SparceMatrix> ranking = rankingCalculator->generateRanking(data);
+    //Si se indica un directorio de cache, buscamos primero el ranking ya calculado
+    std::shared_ptr<SparceMatrix> ranking;
+    if(argc > 4) {
+        RankingCache cache(argv[4]);
+        uint64_t key = RankingCache::hash(*data, method);
+        ranking = cache.load(key);
+        if(ranking) {
+            cout << "Cache hit " << cache.entryPath(key) << endl;
+        }
+        else {
+            ranking = rankingCalculator->generateRanking(data);
+            cache.store(key, *ranking);
+        }
+    }
+    else {
+        ranking = rankingCalculator->generateRanking(data);
+    }
 
     cout << "Writing " << outFile << "... " << endl;
     writeOutput(outFile, *ranking);
@@ -68,10 +94,11 @@ int main(int argc, char** argv){
 
 void showHelp(){
     using namespace std;
-    cout << "Forma ejecución './tp entrada salida metodo' donde" << endl;
+    cout << "Forma ejecución './tp entrada salida metodo [cache]' donde" << endl;
     cout << "-entrada: nombre archivo de entrada " << endl;
     cout << "-salida: nombre archivo de salida" << endl;
-    cout << "-metodo: es un número [0=CMM, 1=WP, 2=CMM_ATP]" << endl;
+    cout << "-metodo: es un número [0=CMM, 1=WP, 2=CMM_ATP, 3=CMM por torneo]" << endl;
+    cout << "-cache: (opcional) directorio donde guardar y buscar rankings ya calculados (metodos 0, 1 y 2)" << endl;
 }
 
 void readInput(const std::string &inFileName, std::shared_ptr<TeamsData> &outData){
@@ -102,3 +129,15 @@ void writeOutput(const std::string &outFileName, const SparceMatrix &ranking) {
     }
     file.close();
 }
+
+void writeTournamentsOutput(const std::string &outFileName, const std::map<int, std::map<int, double>> &rankings) {
+    using namespace std;
+    ofstream file(outFileName);
+    for(auto &tournament : rankings){
+        for(auto &score : tournament.second){
+            file << tournament.first << " " << score.first << " "
+                 << setprecision(numeric_limits<double>::digits10) << score.second << endl;
+        }
+    }
+    file.close();
+}
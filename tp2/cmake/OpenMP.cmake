@@ -79,4 +79,9 @@ endif()
 ##    find_package(Threads REQUIRED)
 ##    target_link_libraries(OpenMP_TARGET INTERFACE Threads::Threads)
 ##    target_link_libraries(OpenMP_TARGET INTERFACE ${OpenMP_CXX_FLAGS} ${Additional_OpenMP_Libraries_Workaround})
-#endif()
\ No newline at end of file
+#endif()
+
+if (NOT OpenMP_FOUND)
+    message("OpenMP not found. Ignoring unknown pragmas during compile-time.")
+    set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wno-unknown-pragmas")
+endif()
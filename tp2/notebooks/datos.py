@@ -0,0 +1,26 @@
+import argparse
+import numpy as np
+import pandas as pd
+
+# Lectura y partición del dataset que comparten los scripts de notebooks/ (se corren desde tp2/
+# con python -m notebooks.<script>)
+
+
+def parser():
+    """ArgumentParser con la opción -i/--inputset que usan todos los scripts"""
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-i', '--inputset', default='data/train.csv')
+    return parser
+
+
+def cargar(path):
+    """X como float64 con filas contiguas (el layout de Matrix) e y como columna"""
+    df = pd.read_csv(path)
+    X = np.ascontiguousarray(df[df.columns[1:]].values, dtype=np.float64)
+    y = df["label"].values.reshape(-1, 1)
+    return X, y
+
+
+def separar(X, y, test_rows):
+    """Las primeras test_rows filas son de test y el resto de entrenamiento: X_train, y_train, X_test, y_test"""
+    return X[test_rows:], y[test_rows:], X[:test_rows], y[:test_rows]
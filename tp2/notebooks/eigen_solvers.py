@@ -0,0 +1,24 @@
+import numpy as np
+from notebooks import datos, metnum
+
+# Compara los métodos de autovalores sobre la matriz de covarianza del dataset
+# Uso (desde tp2/): python -m notebooks.eigen_solvers -i data/train.csv -n 10 50 100
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-n', '--num', default=[10, 50], type=int, nargs='+')
+    parser.add_argument('-m', '--methods', default=['power', 'subspace', 'lanczos'], nargs='+')
+    parser.add_argument('-e', '--epsilon', default=1e-10, type=float)
+
+    parameters = parser.parse_args()
+
+    X, _ = datos.cargar(parameters.inputset)
+    center = X - X.mean(axis=0)
+    cov = center.T @ center / (X.shape[0] - 1)
+
+    print("metodo,autovectores,segundos,productos,residuo_max")
+    for num in parameters.num:
+        for method in parameters.methods:
+            result = metnum.eigen_solve(cov, num, method, epsilon=parameters.epsilon)
+            print("{},{},{:.3f},{},{:.2e}".format(method, num, result.seconds, result.products,
+                                                 np.max(result.residuals)))
@@ -0,0 +1,30 @@
+import time
+import numpy as np
+from notebooks import datos, metnum
+
+# Validación cruzada de PCA + KNN con metnum.cross_validate (reemplaza los loops de K-Fold.ipynb y K vs beta.ipynb)
+# Uso (desde tp2/): python -m notebooks.kfold_native -i data/train.csv -f 5 -b 10 20 27 40 -k 1 3 4 5 10 20
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-f', '--folds', default=5, type=int)
+    parser.add_argument('-b', '--betas', default=[10, 20, 27, 40], type=int, nargs='+')
+    parser.add_argument('-k', '--ks', default=[1, 3, 4, 5, 10, 20], type=int, nargs='+')
+    parser.add_argument('-s', '--seed', default=0, type=int)
+
+    parameters = parser.parse_args()
+
+    X, y = datos.cargar(parameters.inputset)
+
+    start = time.time()
+    accuracy = metnum.cross_validate(X, y, parameters.folds, np.array(parameters.betas), np.array(parameters.ks),
+                                     True, parameters.seed)
+    print("# {:.2f} segundos".format(time.time() - start))
+
+    print("beta,k,accuracy_media,accuracy_std")
+    # los folds sin entrenamiento suficiente tienen accuracy NaN
+    mean = np.nanmean(accuracy, axis=0)
+    std = np.nanstd(accuracy, axis=0)
+    for b, beta in enumerate(parameters.betas):
+        for c, k in enumerate(parameters.ks):
+            print("{},{},{:.4f},{:.4f}".format(beta, k, mean[b, c], std[b, c]))
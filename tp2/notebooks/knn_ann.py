@@ -0,0 +1,46 @@
+import time
+import numpy as np
+from notebooks import datos, metnum
+
+# Recall@k y latencia del KNN aproximado (IVF) contra la búsqueda exacta, variando nprobe
+# Uso (desde tp2/): python -m notebooks.knn_ann -i data/train.csv -p 1 2 4 8 16 32
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-k', '--knn', default=4, type=int)
+    parser.add_argument('-q', '--queries', default=5000, type=int)
+    parser.add_argument('-l', '--nlist', default=0, type=int)
+    parser.add_argument('-p', '--nprobe', default=[1, 2, 4, 8, 16, 32], type=int, nargs='+')
+    parser.add_argument('-o', '--index', default=None, help='archivo donde guardar el índice IVF')
+
+    parameters = parser.parse_args()
+
+    X, y = datos.cargar(parameters.inputset)
+
+    X_train, y_train, X_test, y_test = datos.separar(X, y, parameters.queries)
+    y_test = y_test.ravel()
+
+    exact = metnum.KNNClassifier(parameters.knn, algorithm="brute")
+    exact.fit(X_train, y_train)
+    start = time.time()
+    exact_pred = exact.predict(X_test).ravel()
+    exact_time = time.time() - start
+    exact_neighbors = exact.neighbors()
+
+    ann = metnum.KNNClassifier(parameters.knn, algorithm="ivf", nlist=parameters.nlist)
+    start = time.time()
+    ann.fit(X_train, y_train)
+    print("# construcción del índice: {:.3f} s".format(time.time() - start))
+    if parameters.index:
+        ann.save(parameters.index)
+
+    print("nprobe,recall@k,accuracy,segundos,speedup")
+    print("exacto,1.0000,{:.4f},{:.3f},1.00".format(np.mean(exact_pred == y_test), exact_time))
+    for nprobe in parameters.nprobe:
+        ann.setNProbe(nprobe)
+        start = time.time()
+        pred = ann.predict(X_test).ravel()
+        elapsed = time.time() - start
+        neighbors = ann.neighbors()
+        recall = np.mean([len(np.intersect1d(a, b)) / parameters.knn for a, b in zip(neighbors, exact_neighbors)])
+        print("{},{:.4f},{:.4f},{:.3f},{:.2f}".format(nprobe, recall, np.mean(pred == y_test), elapsed, exact_time / elapsed))
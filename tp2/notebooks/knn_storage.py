@@ -0,0 +1,35 @@
+import time
+import numpy as np
+from notebooks import datos, metnum
+
+# Accuracy, tiempo de predict y memoria de KNN con cada forma de guardar el entrenamiento
+# Uso (desde tp2/): python -m notebooks.knn_storage -i data/train.csv -s double float uint8 pq
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-k', '--knn', default=4, type=int)
+    parser.add_argument('-q', '--queries', default=5000, type=int)
+    parser.add_argument('-s', '--storage', default=['double', 'float', 'uint8', 'pq'], nargs='+')
+    parser.add_argument('-m', '--pq_subspaces', default=0, type=int)
+
+    parameters = parser.parse_args()
+
+    X, y = datos.cargar(parameters.inputset)
+
+    X_train, y_train, X_test, y_test = datos.separar(X, y, parameters.queries)
+    y_test = y_test.ravel()
+
+    base = None
+    print("storage,accuracy,fit_segundos,predict_segundos,speedup,MB")
+    for storage in parameters.storage:
+        knn = metnum.KNNClassifier(parameters.knn, algorithm="brute", storage=storage,
+                                   pq_subspaces=parameters.pq_subspaces)
+        start = time.time()
+        knn.fit(X_train, y_train)
+        fit_time = time.time() - start
+        start = time.time()
+        pred = knn.predict(X_test).ravel()
+        elapsed = time.time() - start
+        base = base or elapsed
+        print("{},{:.4f},{:.3f},{:.3f},{:.2f},{:.1f}".format(storage, np.mean(pred == y_test), fit_time, elapsed,
+                                                           base / elapsed, knn.trainMemory() / 2 ** 20))
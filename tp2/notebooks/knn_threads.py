@@ -0,0 +1,30 @@
+import time
+from notebooks import datos, metnum
+
+# Escalamiento fuerte de KNNClassifier.predict: mismo problema, distinta cantidad de threads
+# Uso (desde tp2/): python -m notebooks.knn_threads -i data/train.csv -t 1 2 4 8
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-k', '--knn', default=4, type=int)
+    parser.add_argument('-q', '--queries', default=5000, type=int)
+    parser.add_argument('-t', '--threads', default=[1, 2, 4, 8], type=int, nargs='+')
+
+    parameters = parser.parse_args()
+
+    X, y = datos.cargar(parameters.inputset)
+
+    X_train, y_train, X_test, _ = datos.separar(X, y, parameters.queries)
+
+    knn = metnum.KNNClassifier(parameters.knn)
+    knn.fit(X_train, y_train)
+
+    base = None
+    print("threads,segundos,speedup")
+    for threads in parameters.threads:
+        metnum.set_num_threads(threads)
+        start = time.time()
+        knn.predict(X_test)
+        elapsed = time.time() - start
+        base = base or elapsed
+        print("{},{:.3f},{:.2f}".format(threads, elapsed, base / elapsed))
@@ -0,0 +1,35 @@
+import resource
+import time
+from notebooks import datos, metnum
+
+# PCA incremental leyendo el archivo de a lotes: la memoria máxima depende del lote, no del archivo
+# Uso (desde tp2/): python -m notebooks.pca_incremental -i data/train.csv -a 50 -b 1000
+# El archivo puede ser CSV o el formato binario de metnum.write_binary (se detecta solo)
+
+def peak_rss_mb():
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-a', '--alpha', default=50, type=int)
+    parser.add_argument('-b', '--batch', default=1000, type=int)
+    parser.add_argument('-s', '--skip_columns', default=1, type=int, help='columnas iniciales a ignorar (label)')
+
+    parameters = parser.parse_args()
+
+    path = parameters.inputset
+    reader = metnum.BatchReader(path, parameters.batch, parameters.skip_columns)
+    if not reader.good():
+        raise SystemExit("No se pudo leer {}".format(path))
+
+    pca = metnum.PCA(parameters.alpha)
+    start = time.time()
+    rows = 0
+    while True:
+        batch = reader.next()
+        if batch.shape[0] == 0:
+            break
+        pca.partial_fit(batch)
+        rows += batch.shape[0]
+    print("filas {}, columnas {}, {:.3f} s, RSS máximo {:.1f} MB".format(rows, reader.columns(),
+                                                                         time.time() - start, peak_rss_mb()))
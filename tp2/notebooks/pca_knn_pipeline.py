@@ -0,0 +1,36 @@
+import time
+from notebooks import datos, metnum
+
+# Compara PCA.transform + KNNClassifier por separado contra PCAKNNPipeline
+# Uso (desde tp2/): python -m notebooks.pca_knn_pipeline -i data/train.csv -a 27 -k 4 -t 8000
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-a', '--alpha', default=27, type=int)
+    parser.add_argument('-k', '--neighbors', default=4, type=int)
+    parser.add_argument('-t', '--test_rows', default=8000, type=int)
+    parser.add_argument('-r', '--repetitions', default=5, type=int)
+
+    parameters = parser.parse_args()
+
+    X, y = datos.cargar(parameters.inputset)
+    X_train, y_train, X_test, y_test = datos.separar(X, y, parameters.test_rows)
+
+    pca = metnum.PCA(parameters.alpha)
+    pca.fit(X_train)
+    knn = metnum.KNNClassifier(parameters.neighbors)
+    knn.fit(pca.transform(X_train), y_train)
+
+    pipeline = metnum.PCAKNNPipeline(parameters.alpha, parameters.neighbors)
+    pipeline.fit(X_train, y_train)
+
+    print("metodo,segundos,accuracy")
+    for name, run in [("separado", lambda: knn.predict(pca.transform(X_test))),
+                      ("pipeline", lambda: pipeline.predict(X_test))]:
+        best = float("inf")
+        for _ in range(parameters.repetitions):
+            start = time.time()
+            prediction = run()
+            best = min(best, time.time() - start)
+        accuracy = (prediction.reshape(-1) == y_test.reshape(-1)).mean()
+        print("{},{:.4f},{:.4f}".format(name, best, accuracy))
@@ -0,0 +1,42 @@
+import time
+import numpy as np
+from notebooks import datos, metnum
+
+# Compara PCA con SVD aleatorizada contra el cálculo con la matriz de covarianza
+# Uso (desde tp2/): python -m notebooks.pca_randomized -i data/train.csv -a 27 50 -p 0 1 2 4
+
+def variance(X, base):
+    center = X - X.mean(axis=0)
+    return np.sum((center @ base) ** 2) / (X.shape[0] - 1)
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-a', '--alpha', default=[27, 50], type=int, nargs='+')
+    parser.add_argument('-o', '--oversampling', default=10, type=int)
+    parser.add_argument('-p', '--power_iterations', default=[0, 1, 2, 4], type=int, nargs='+')
+
+    parameters = parser.parse_args()
+
+    X, _ = datos.cargar(parameters.inputset)
+
+    # cos_min: coseno del mayor ángulo entre los subespacios (1 es el mismo subespacio)
+    print("alpha,solver,power_iterations,segundos,varianza_relativa,cos_min")
+    for alpha in parameters.alpha:
+        reference = metnum.PCA(alpha, "subspace")
+        start = time.time()
+        reference.fit(X)
+        elapsed = time.time() - start
+        base = reference.components()
+        reference_variance = variance(X, base)
+        print("{},subspace,-,{:.3f},1.0000,1.0000".format(alpha, elapsed))
+
+        for power_iterations in parameters.power_iterations:
+            pca = metnum.PCA(alpha, "randomized", parameters.oversampling, power_iterations)
+            start = time.time()
+            pca.fit(X)
+            elapsed = time.time() - start
+            components = pca.components()
+            cosines = np.linalg.svd(base.T @ components, compute_uv=False)
+            print("{},randomized,{},{:.3f},{:.4f},{:.4f}".format(alpha, power_iterations, elapsed,
+                                                               variance(X, components) / reference_variance,
+                                                               cosines.min()))
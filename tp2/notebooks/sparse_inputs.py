@@ -0,0 +1,52 @@
+import time
+import scipy.sparse
+from notebooks import datos, metnum
+
+# Compara PCA + KNN con las imágenes densas contra las mismas como scipy.sparse.csr_matrix
+# (la mayoría de los píxeles de MNIST son 0)
+# Uso (desde tp2/): python -m notebooks.sparse_inputs -i data/train.csv -a 27 -k 4 -t 8000
+
+if __name__ == "__main__":
+    parser = datos.parser()
+    parser.add_argument('-a', '--alpha', default=27, type=int)
+    parser.add_argument('-k', '--neighbors', default=4, type=int)
+    parser.add_argument('-t', '--test_rows', default=8000, type=int)
+
+    parameters = parser.parse_args()
+
+    X, y = datos.cargar(parameters.inputset)
+    X_train, y_train, X_test, y_test = datos.separar(X, y, parameters.test_rows)
+    S_train, S_test = scipy.sparse.csr_matrix(X_train), scipy.sparse.csr_matrix(X_test)
+    print("no nulos: {:.1%}".format(S_train.nnz / float(X_train.size)))
+
+    def dense():
+        knn = metnum.KNNClassifier(parameters.neighbors, algorithm="brute")
+        knn.fit(X_train, y_train)
+        return knn.predict(X_test)
+
+    def sparse():
+        knn = metnum.KNNClassifier(parameters.neighbors)
+        knn.fitSparse(S_train, y_train)
+        return knn.predictSparse(S_test)
+
+    def pca_dense():
+        pca = metnum.PCA(parameters.alpha, "randomized")
+        pca.fit(X_train)
+        return pca.transform(X_test)
+
+    def pca_sparse():
+        pca = metnum.PCA(parameters.alpha, "randomized")
+        pca.fitSparse(S_train)
+        return pca.transformSparse(S_test)
+
+    print("metodo,segundos,accuracy")
+    for name, run in [("knn denso", dense), ("knn ralo", sparse)]:
+        start = time.time()
+        prediction = run()
+        accuracy = (prediction.reshape(-1) == y_test.reshape(-1)).mean()
+        print("{},{:.4f},{:.4f}".format(name, time.time() - start, accuracy))
+
+    for name, run in [("pca denso", pca_dense), ("pca ralo", pca_sparse)]:
+        start = time.time()
+        run()
+        print("{},{:.4f},".format(name, time.time() - start))
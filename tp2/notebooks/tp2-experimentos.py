@@ -13,7 +13,9 @@ if not os.path.exists('../data/tests'):
 
 
 def run_knn(parameters, X_train, y_train, X_test, y_test,beta_used=None):
-    knn = metnum.KNNClassifier(parameters.knn)
+    # si se barren varios k, guardamos hasta allKEnd vecinos por consulta para predictWithK
+    k_max = parameters.allKEnd if parameters.allK else 0
+    knn = metnum.KNNClassifier(parameters.knn, k_max)
 
     knn.fit(X_train, y_train)
     y_predict = knn.predict(X_test)
@@ -36,9 +38,11 @@ def run_knn(parameters, X_train, y_train, X_test, y_test,beta_used=None):
     if parameters.allK:
         data = {}
         ks = range(parameters.allKStart, parameters.allKEnd, parameters.allKStep)
+        # una sola votación por consulta para todos los k; la columna i tiene las predicciones de ks[i]
+        predictions = knn.predictWithKs(np.array(ks))
 
-        for k in ks:
-            y_predict = [int(value) for value in knn.predictWithK(k)]
+        for i, k in enumerate(ks):
+            y_predict = [int(value) for value in predictions[:, i]]
 
             acc         = accuracy_score(y_test, y_predict)
             # recall      = recall_score  (y_test, y_predict, labels=range(10), average=None)
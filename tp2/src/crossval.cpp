@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "crossval.h"
+#include "eigen.h"
+#include "knn.h"
+#include "pca.h"
+
+using namespace std;
+
+Matrix cross_validate(const MatrixRef& X, const IntVector& y, unsigned int folds,
+                      const IntVector& betas, const IntVector& ks,
+                      bool shuffle, unsigned int seed, const std::string& solver)
+{
+    Eigen::Index n = X.rows();
+    Eigen::Index d = X.cols();
+    if (n < 2 || y.rows() != n)
+    {
+        throw std::invalid_argument("cross_validate: hacen falta al menos dos filas y una etiqueta por fila");
+    }
+    if (folds < 2 || folds > n)
+    {
+        throw std::invalid_argument("cross_validate: folds tiene que estar entre 2 y la cantidad de filas");
+    }
+    if ((betas.size() > 0 && betas.minCoeff() < 1) || (ks.size() > 0 && ks.minCoeff() < 1))
+    {
+        throw std::invalid_argument("cross_validate: cada beta y cada k tiene que ser al menos 1");
+    }
+    Matrix accuracy = Matrix::Zero(folds * betas.size(), ks.size());
+    if (betas.size() == 0 || ks.size() == 0)
+    {
+        return accuracy;
+    }
+    unsigned int maxBeta = std::min<size_t>(betas.maxCoeff(), d);
+    unsigned int maxK = ks.maxCoeff();
+
+    vector<Eigen::Index> permutation(n);
+    iota(permutation.begin(), permutation.end(), 0);
+    if (shuffle)
+    {
+        std::mt19937 generator(seed);
+        std::shuffle(permutation.begin(), permutation.end(), generator);
+    }
+
+    // X^T X y la suma de las filas, una sola vez para todos los folds
+    RowVector sum = X.colwise().sum();
+    Matrix allCovariance = covariance(X);
+    Matrix gram = allCovariance * double(n - 1) + sum.transpose() * sum / double(n);
+    // Las componentes de todos los datos están muy cerca de las de cada fold: los solvers de los
+    // folds arrancan desde ahí
+    Matrix start = eigen_solve(allCovariance, maxBeta, solver).eigenvectors;
+    allCovariance.resize(0, 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (unsigned int fold = 0; fold < folds; ++fold)
+    {
+        Eigen::Index first = fold * n / folds;
+        Eigen::Index testRows = (fold + 1) * n / folds - first;
+        Eigen::Index trainRows = n - testRows;
+        // Un fold sin test o con menos de dos filas de entrenamiento no tiene covarianza ni accuracy
+        if (testRows == 0 || trainRows < 2)
+        {
+            accuracy.middleRows(fold * betas.size(), betas.size()).setConstant(std::numeric_limits<double>::quiet_NaN());
+            continue;
+        }
+
+        Matrix XTest(testRows, d);
+        for (Eigen::Index i = 0; i < testRows; ++i)
+        {
+            XTest.row(i) = X.row(permutation[first + i]);
+        }
+
+        // Covarianza del entrenamiento: (X^T X - Xtest^T Xtest - n_train mu mu^T) / (n_train - 1)
+        RowVector mean = (sum - XTest.colwise().sum()) / double(trainRows);
+        Matrix cov = gram;
+        cov.noalias() -= XTest.transpose() * XTest;
+        cov.noalias() -= double(trainRows) * mean.transpose() * mean;
+        cov /= double(trainRows - 1);
+        Matrix base = eigen_solve(cov, maxBeta, solver, 1000, 1e-10, start).eigenvectors;
+
+        // Proyección con maxBeta componentes de todas las filas, centrada con la media del entrenamiento
+        Matrix projected = X * base;
+        projected.rowwise() -= mean * base;
+        Matrix train(trainRows, maxBeta);
+        Matrix test(testRows, maxBeta);
+        IntVector yTrain(trainRows);
+        IntVector yTest(testRows);
+        for (Eigen::Index i = 0, j = 0; i < n; ++i)
+        {
+            Eigen::Index row = permutation[i];
+            if (i >= first && i < first + testRows)
+            {
+                test.row(i - first) = projected.row(row);
+                yTest(i - first) = y(row);
+            }
+            else
+            {
+                train.row(j) = projected.row(row);
+                yTrain(j++) = y(row);
+            }
+        }
+
+        for (Eigen::Index b = 0; b < betas.size(); ++b)
+        {
+            Eigen::Index beta = std::max<Eigen::Index>(1, std::min<Eigen::Index>(betas(b), maxBeta));
+            KNNClassifier knn(1, maxK);
+            knn.fitNoCopy(train.leftCols(beta), yTrain);
+            knn.predict(test.leftCols(beta));
+            IntMatrix predictions = knn.predictWithKs(ks);
+            for (Eigen::Index c = 0; c < ks.size(); ++c)
+            {
+                accuracy(fold * betas.size() + b, c) = (predictions.col(c).array() == yTest.array()).count() / double(testRows);
+            }
+        }
+    }
+
+    return accuracy;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include "types.h"
+
+/*
+Validación cruzada de PCA + KNN con k folds para una grilla de betas (componentes) y de k (vecinos).
+
+Las particiones se arman una sola vez (mezclando las filas con seed si shuffle es true). En cada
+fold PCA se ajusta una sola vez con max(betas) componentes: la covarianza del entrenamiento sale
+de X^T X, que se calcula una vez para todos los folds, restándole la parte del fold de test, y
+el solver arranca desde las componentes de todos los datos.
+Como las componentes de un beta son las primeras del beta máximo, todas las proyecciones son
+columnas de la misma proyección. Para cada beta hay una sola búsqueda de max(ks) vecinos por
+consulta y todos los k se votan en una pasada sobre esos vecinos (KNNClassifier::predictWithKs).
+Los folds corren en paralelo.
+
+Devuelve la accuracy de cada (fold, beta, k) en la fila fold * betas.size() + índice del beta
+y la columna del k. solver es el de PCA ("subspace", "lanczos" o "power").
+Hace falta 2 <= folds <= filas de X, una etiqueta por fila y betas y ks de al menos 1; si no,
+tira std::invalid_argument (ValueError desde Python).
+Los folds que quedan con menos de dos filas de entrenamiento tienen accuracy NaN.
+*/
+Matrix cross_validate(const MatrixRef& X, const IntVector& y, unsigned int folds,
+                      const IntVector& betas, const IntVector& ks,
+                      bool shuffle = true, unsigned int seed = 0, const std::string& solver = "subspace");
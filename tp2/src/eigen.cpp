@@ -1,37 +1,375 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <Eigen/Eigenvalues>
 #include "eigen.h"
 
 using namespace std;
 
-pair<double, Vector> power_iteration(const Matrix& A, unsigned iterations, double epsilon)
+// Cada cuántas iteraciones del método de la potencia se mira si convergió
+static const unsigned POWER_CHECK_EVERY = 4;
+
+// Filas de A por bloque del producto matriz-vector; cada thread hace bloques enteros
+static const Eigen::Index MATVEC_BLOCK_ROWS = 128;
+
+/**
+* w = A v repartiendo bloques de filas de A entre los threads: Eigen solo paraleliza los productos
+* de matrices, no el matriz-vector. Cada bloque es un matriz-vector de Eigen sobre sus filas y
+* escribe solo su parte de w, así que el resultado no depende de la cantidad de threads.
+*/
+static void matvec(const MatrixRef& A, const Vector& v, Vector& w)
+{
+    Eigen::Index blocks = (A.rows() + MATVEC_BLOCK_ROWS - 1) / MATVEC_BLOCK_ROWS;
+    #pragma omp parallel for schedule(static) if (blocks > 1)
+    for (Eigen::Index block = 0; block < blocks; ++block)
+    {
+        Eigen::Index first = block * MATVEC_BLOCK_ROWS;
+        Eigen::Index rows = std::min(MATVEC_BLOCK_ROWS, A.rows() - first);
+        w.segment(first, rows).noalias() = A.middleRows(first, rows) * v;
+    }
+}
+
+// Vector de norma 1 con coordenadas gaussianas
+static Vector random_unit(Eigen::Index size, std::mt19937& generator)
+{
+    std::normal_distribution<double> normal;
+    Vector v(size);
+    for (Eigen::Index i = 0; i < size; ++i)
+    {
+        v(i) = normal(generator);
+    }
+    return v.normalized();
+}
+
+// Las versiones con 'products' cuentan los productos matriz-vector (un producto por un bloque
+// cuenta una vez por columna), para comparar métodos en eigen_solve.
+// v y w se alternan como buffers, así que las iteraciones no piden memoria
+static pair<double, Vector> power_iteration(const MatrixRef& A, unsigned iterations, double epsilon, unsigned& products,
+                                            Vector v)
 {
-    Vector v = Vector::Random(A.cols());
-    for (size_t i = 0; i < iterations; ++i) {
-        Vector o = v;
-        v = A * v;
-        v.normalize();
-        if ((v - o).squaredNorm() < epsilon * epsilon) {
+    Vector w(A.rows());
+    iterations = std::max(1u, iterations);
+    for (unsigned i = 0; i < iterations; ++i) {
+        ++products;
+        matvec(A, v, w);
+        w.normalize();
+        bool converged = (i + 1) % POWER_CHECK_EVERY == 0 && (w - v).squaredNorm() < epsilon * epsilon;
+        v.swap(w);
+        if (converged) {
             break;
         }
     }
-    double eigenvalue = ((v.transpose()*A*v)/(v.transpose()*v))(0);
+    matvec(A, v, w);
+    double eigenvalue = v.dot(w);
 
-    return make_pair(eigenvalue, v / v.norm());
+    return make_pair(eigenvalue, v);
 }
 
-pair<Vector, Matrix> get_first_eigenvalues(const Matrix& A, unsigned n, unsigned iterations, double epsilon)
+pair<double, Vector> power_iteration(const MatrixRef& A, unsigned iterations, double epsilon, unsigned seed)
 {
+    unsigned products = 0;
+    std::mt19937 generator(seed);
+    return power_iteration(A, iterations, epsilon, products, random_unit(A.cols(), generator));
+}
+
+// Columnas de initial que sirven para arrancar: las de la dimensión de A, hasta 'limit'
+static Eigen::Index usable_columns(const MatrixRef& A, const MatrixRef& initial, Eigen::Index limit)
+{
+    return initial.rows() == A.rows() ? std::min(initial.cols(), limit) : 0;
+}
+
+static pair<Vector, Matrix> get_first_eigenvalues(const MatrixRef& A, unsigned n, unsigned iterations, double epsilon,
+                                                  unsigned& products, const MatrixRef& initial, unsigned seed = 0)
+{
+    std::mt19937 generator(seed);
     Matrix M(A);
     Matrix eigenvectors(A.rows(), n);
     Vector eigenvalues(n);
+    Eigen::Index warm = usable_columns(A, initial, n);
+    Matrix start;
+    if (warm > 0)
+    {
+        // Rayleigh-Ritz sobre las columnas de initial: si los datos cambiaron, los autovectores
+        // viejos pueden haberse mezclado entre sí aunque el subespacio que generan casi no se mueva
+        start = Eigen::HouseholderQR<Matrix>(initial.leftCols(warm)).householderQ() * Matrix::Identity(A.rows(), warm);
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritz(start.transpose() * A * start);
+        products += warm;
+        start = start * ritz.eigenvectors().rowwise().reverse();
+    }
     for (size_t i = 0; i < n; ++i) {
-        pair<double, Vector> e = power_iteration(M, iterations, epsilon);
+        // Cada autovector arranca de la columna correspondiente de initial, si la hay
+        pair<double, Vector> e = power_iteration(M, iterations, epsilon, products,
+                                                 (Eigen::Index)i < warm ? Vector(start.col(i))
+                                                                        : random_unit(A.cols(), generator));
         eigenvalues(i) = e.first;
         eigenvectors.col(i) = e.second;
-        M = M - e.first * (e.second * e.second.transpose());
+        M.noalias() -= (e.first * e.second) * e.second.transpose();
     }
 
     return make_pair(eigenvalues, eigenvectors);
 }
+
+pair<Vector, Matrix> get_first_eigenvalues(const MatrixRef& A, unsigned n, unsigned iterations, double epsilon,
+                                           const MatrixRef& initial, unsigned seed)
+{
+    unsigned products = 0;
+    return get_first_eigenvalues(A, n, iterations, epsilon, products, initial, seed);
+}
+
+static pair<Vector, Matrix> subspace_iteration(const MatrixRef& A, unsigned n, unsigned iterations, double epsilon,
+                                               unsigned& products, const MatrixRef& initial)
+{
+    Eigen::Index size = A.rows();
+    Eigen::Index num = std::min<Eigen::Index>(n, size);
+    // Vectores extra para que los últimos autovalores pedidos converjan más rápido
+    Eigen::Index block = std::min<Eigen::Index>(size, num + std::max<Eigen::Index>(num / 2, 8));
+
+    // Bloque inicial al azar (con semilla fija para que el resultado sea reproducible); las primeras
+    // columnas se reemplazan por las de initial, así que si ya son autovectores convergen enseguida
+    std::mt19937 generator(0);
+    std::normal_distribution<double> normal;
+    Matrix X(size, block);
+    for (Eigen::Index i = 0; i < X.size(); ++i)
+    {
+        X.data()[i] = normal(generator);
+    }
+    Eigen::Index warm = usable_columns(A, initial, block);
+    if (warm > 0)
+    {
+        X.leftCols(warm) = initial.leftCols(warm);
+    }
+    X = Eigen::HouseholderQR<Matrix>(X).householderQ() * Matrix::Identity(size, block);
+
+    // Columnas [0, locked) de vectors ya convergieron
+    Matrix vectors(size, num);
+    Vector values(num);
+    Eigen::Index locked = 0;
+    iterations = std::max(1u, iterations);
+    for (unsigned it = 0; it < iterations && locked < num; ++it)
+    {
+        Matrix AX = A * X;
+        products += X.cols();
+
+        // Rayleigh-Ritz: autopares de la proyección de A sobre el bloque, ordenados por módulo
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritz(X.transpose() * AX);
+        std::vector<Eigen::Index> order(X.cols());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        const Vector& theta = ritz.eigenvalues();
+        std::sort(order.begin(), order.end(), [&theta](Eigen::Index a, Eigen::Index b) {
+            return std::abs(theta(a)) > std::abs(theta(b));
+        });
+        Matrix S(X.cols(), X.cols());
+        Vector sortedTheta(X.cols());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            S.col(i) = ritz.eigenvectors().col(order[i]);
+            sortedTheta(i) = theta(order[i]);
+        }
+        X = X * S;
+        AX = AX * S;
+
+        // Bloqueamos los primeros autopares consecutivos que convergieron
+        double scale = std::abs(locked > 0 ? values(0) : sortedTheta(0));
+        Eigen::Index converged = 0;
+        while (locked + converged < num && converged < X.cols()
+               && (AX.col(converged) - sortedTheta(converged) * X.col(converged)).norm() <= epsilon * scale)
+        {
+            vectors.col(locked + converged) = X.col(converged);
+            values(locked + converged) = sortedTheta(converged);
+            ++converged;
+        }
+        locked += converged;
+
+        if (locked == num || it + 1 == iterations)
+        {
+            // Los que no convergieron se devuelven con la última aproximación
+            for (Eigen::Index i = converged; locked < num; ++i, ++locked)
+            {
+                vectors.col(locked) = X.col(i);
+                values(locked) = sortedTheta(i);
+            }
+            break;
+        }
+
+        // Paso de potencia sobre los que faltan, ortogonal a los bloqueados
+        Eigen::Index active = std::min<Eigen::Index>(X.cols() - converged, size - locked);
+        Matrix W = AX.middleCols(converged, active);
+        W -= vectors.leftCols(locked) * (vectors.leftCols(locked).transpose() * W);
+        X = Eigen::HouseholderQR<Matrix>(W).householderQ() * Matrix::Identity(size, active);
+    }
+
+    return make_pair(values, vectors);
+}
+
+pair<Vector, Matrix> subspace_iteration(const MatrixRef& A, unsigned n, unsigned iterations, double epsilon,
+                                        const MatrixRef& initial)
+{
+    unsigned products = 0;
+    return subspace_iteration(A, n, iterations, epsilon, products, initial);
+}
+
+/**
+* Lanczos con reinicio grueso (thick restart): la base de Krylov crece hasta 'basis' vectores,
+* se calculan los vectores de Ritz y se reinicia conservando los mejores. Se reortogonaliza contra
+* toda la base dos veces por paso (DGKS), que para las dimensiones de PCA cuesta mucho menos que
+* el producto por A. Se mantiene A V = V T + beta v e^T, así que el residuo de cada par de Ritz
+* sale de la última fila de los autovectores de T sin multiplicar por A.
+*/
+static pair<Vector, Matrix> lanczos(const MatrixRef& A, unsigned n, unsigned iterations, double epsilon,
+                                    unsigned& products, const MatrixRef& initial)
+{
+    Eigen::Index size = A.rows();
+    Eigen::Index num = std::min<Eigen::Index>(n, size);
+    Eigen::Index basis = std::min<Eigen::Index>(size, std::max<Eigen::Index>(2 * num + 1, num + 20));
+    // Vectores de Ritz que se conservan en cada reinicio
+    Eigen::Index keep = std::min<Eigen::Index>(basis - 1, num + (basis - num) / 2);
+
+    std::mt19937 generator(0);
+    std::normal_distribution<double> normal;
+    auto randomOrthogonal = [&](Eigen::Index columns, const Eigen::MatrixXd& V) {
+        Vector v(size);
+        for (Eigen::Index i = 0; i < size; ++i)
+        {
+            v(i) = normal(generator);
+        }
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            v -= V.leftCols(columns) * (V.leftCols(columns).transpose() * v);
+        }
+        return Vector(v.normalized());
+    };
+
+    Eigen::MatrixXd V(size, basis + 1);
+    Eigen::MatrixXd T = Eigen::MatrixXd::Zero(basis, basis);
+    // Con initial se arranca de la suma de sus columnas: el espacio de Krylov las contiene a todas
+    // en pocos pasos
+    Eigen::Index warm = usable_columns(A, initial, num);
+    Vector first = warm > 0 ? Vector(initial.leftCols(warm).rowwise().sum()) : Vector();
+    V.col(0) = warm > 0 && first.norm() > 0 ? Vector(first.normalized()) : randomOrthogonal(0, V);
+    Eigen::Index start = 0;
+    double beta = 0;
+
+    Eigen::MatrixXd S;
+    Vector theta;
+    std::vector<Eigen::Index> order(basis);
+    iterations = std::max(1u, iterations);
+    for (unsigned restart = 0; restart < iterations; ++restart)
+    {
+        for (Eigen::Index j = start; j < basis; ++j)
+        {
+            Vector w = A * V.col(j);
+            ++products;
+            Vector h = V.leftCols(j + 1).transpose() * w;
+            w -= V.leftCols(j + 1) * h;
+            Vector correction = V.leftCols(j + 1).transpose() * w;
+            w -= V.leftCols(j + 1) * correction;
+            h += correction;
+
+            T.col(j).head(j + 1) = h;
+            T.row(j).head(j + 1) = h.transpose();
+            beta = w.norm();
+            if (beta <= 1e-14 * std::max(1.0, std::abs(T(0, 0))))
+            {
+                // Subespacio invariante: seguimos con un vector nuevo sin acoplar
+                beta = 0;
+                V.col(j + 1) = randomOrthogonal(j + 1, V);
+            }
+            else
+            {
+                V.col(j + 1) = w / beta;
+            }
+            if (j + 1 < basis)
+            {
+                T(j + 1, j) = T(j, j + 1) = beta;
+            }
+        }
+
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritz(T);
+        theta = ritz.eigenvalues();
+        for (Eigen::Index i = 0; i < basis; ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&theta](Eigen::Index a, Eigen::Index b) {
+            return std::abs(theta(a)) > std::abs(theta(b));
+        });
+        S.resize(basis, basis);
+        Vector sortedTheta(basis);
+        for (Eigen::Index i = 0; i < basis; ++i)
+        {
+            S.col(i) = ritz.eigenvectors().col(order[i]);
+            sortedTheta(i) = theta(order[i]);
+        }
+        theta = sortedTheta;
+
+        double scale = std::abs(theta(0));
+        Eigen::Index converged = 0;
+        while (converged < num && std::abs(beta * S(basis - 1, converged)) <= epsilon * scale)
+        {
+            ++converged;
+        }
+        if (converged == num || basis == size || restart + 1 == iterations)
+        {
+            break;
+        }
+
+        // Reinicio: los 'keep' mejores vectores de Ritz y el último vector de la base
+        Eigen::MatrixXd kept = V.leftCols(basis) * S.leftCols(keep);
+        V.leftCols(keep) = kept;
+        V.col(keep) = V.col(basis);
+        T.setZero();
+        for (Eigen::Index i = 0; i < keep; ++i)
+        {
+            T(i, i) = theta(i);
+            T(i, keep) = T(keep, i) = beta * S(basis - 1, i);
+        }
+        start = keep;
+    }
+
+    Matrix vectors = V.leftCols(basis) * S.leftCols(num);
+    return make_pair(Vector(theta.head(num)), vectors);
+}
+
+pair<Vector, Matrix> lanczos(const MatrixRef& A, unsigned n, unsigned iterations, double epsilon,
+                             const MatrixRef& initial)
+{
+    unsigned products = 0;
+    return lanczos(A, n, iterations, epsilon, products, initial);
+}
+
+EigenResult eigen_solve(const MatrixRef& A, unsigned n, const std::string& method, unsigned iterations, double epsilon,
+                        const MatrixRef& initial)
+{
+    EigenResult result;
+    result.products = 0;
+    auto start = std::chrono::steady_clock::now();
+    pair<Vector, Matrix> e;
+    if (method == "power")
+    {
+        e = get_first_eigenvalues(A, n, iterations, epsilon, result.products, initial);
+    }
+    else if (method == "lanczos")
+    {
+        e = lanczos(A, n, iterations, epsilon, result.products, initial);
+    }
+    else if (method == "subspace")
+    {
+        e = subspace_iteration(A, n, iterations, epsilon, result.products, initial);
+    }
+    else
+    {
+        throw std::invalid_argument("eigen_solve: method tiene que ser \"power\", \"subspace\" o \"lanczos\"");
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.eigenvalues = e.first;
+    result.eigenvectors = e.second;
+    result.residuals = ((A * result.eigenvectors) - result.eigenvectors * result.eigenvalues.asDiagonal())
+                           .colwise().norm().transpose();
+    return result;
+}
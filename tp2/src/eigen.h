@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include "types.h"
 
 /*
@@ -7,14 +8,17 @@ Calcula el autovalor (y autovector correspondiente) de módulo máximo
 Parámetros:
 ----------
 
-mat: const Matrix& mat
+mat: const MatrixRef& mat
     Matriz sobre la que queremos calcular el autovalor
 
 num_iter: unsigned (=5000 por defecto)
     Cantidad de iteraciones a correr
 
 eps: double
-    Tolerancia a residuo (opcional)
+    Tolerancia a residuo (opcional); la convergencia se mira cada 4 iteraciones
+
+seed: unsigned (=0 por defecto)
+    Semilla del vector inicial: con la misma semilla el resultado y las iteraciones son siempre los mismos
 
 Devuelve:
 --------
@@ -23,7 +27,7 @@ pair<double, Vector> donde el primer valor es el autovalor
 y el segundo el autovector asociado
 */
 std::pair<double, Vector>
-    power_iteration(const Matrix& mat, unsigned num_iter=5000, double eps=1e-16);
+    power_iteration(const MatrixRef& mat, unsigned num_iter=5000, double eps=1e-16, unsigned seed=0);
 
 
 /*
@@ -32,7 +36,7 @@ Calcula
 Parámetros:
 ----------
 
-mat: const Matrix& mat
+mat: const MatrixRef& mat
     Matriz sobre la que queremos calcular el autovalor
 
 num: unsigned (=5000 por defecto)
@@ -43,6 +47,13 @@ num_iter: unsigned (=5000 por defecto)
 
 eps: double
     Tolerancia a residuo (opcional)
+
+initial: const MatrixRef& (vacía por defecto)
+    Autovectores de un ajuste anterior (uno por columna) para arrancar el método de la potencia
+    de cada autovalor desde ahí en lugar de un vector al azar (opcional)
+
+seed: unsigned (=0 por defecto)
+    Semilla de los vectores iniciales al azar
 Devuelve:
 --------
 
@@ -52,4 +63,73 @@ pair<Vector, Matrix> donde:
       correspondientes
 */
 std::pair<Eigen::VectorXd, Matrix>
-    get_first_eigenvalues(const Matrix& mat, unsigned num, unsigned num_iter=5000, double epsilon=1e-16);
+    get_first_eigenvalues(const MatrixRef& mat, unsigned num, unsigned num_iter=5000, double epsilon=1e-16,
+                          const MatrixRef& initial=Matrix(), unsigned seed=0);
+
+
+/*
+Calcula los num autovalores de mayor módulo (y sus autovectores) de una matriz simétrica
+con iteración en subespacios: se itera un bloque de vectores a la vez (un producto de matrices
+por iteración), se reortonormaliza con QR y se extraen los autopares con Rayleigh-Ritz.
+Los autopares que convergen se bloquean y dejan de multiplicarse.
+
+Parámetros:
+----------
+
+mat: const MatrixRef& mat
+    Matriz simétrica sobre la que queremos calcular los autovalores
+
+num: unsigned
+    Cantidad de autovectores/autovalores a calcular
+
+num_iter: unsigned (=1000 por defecto)
+    Cantidad máxima de iteraciones
+
+eps: double (=1e-10 por defecto)
+    Un autopar converge cuando ||A v - λ v|| <= eps * |λ_1|
+
+initial: const MatrixRef& (vacía por defecto)
+    Base de un ajuste anterior: sus columnas reemplazan a las primeras del bloque inicial al azar
+
+Devuelve:
+--------
+
+pair<Vector, Matrix> igual que get_first_eigenvalues, con los autovalores ordenados por módulo
+*/
+std::pair<Eigen::VectorXd, Matrix>
+    subspace_iteration(const MatrixRef& mat, unsigned num, unsigned num_iter=1000, double epsilon=1e-10,
+                       const MatrixRef& initial=Matrix());
+
+
+/*
+Calcula los num autovalores de mayor módulo (y sus autovectores) de una matriz simétrica
+con Lanczos con reinicio grueso y reortogonalización completa.
+
+Parámetros y resultado como en subspace_iteration; num_iter es la cantidad máxima de reinicios.
+Con initial el primer vector de la base es la suma normalizada de sus columnas.
+*/
+std::pair<Eigen::VectorXd, Matrix>
+    lanczos(const MatrixRef& mat, unsigned num, unsigned num_iter=1000, double epsilon=1e-10,
+            const MatrixRef& initial=Matrix());
+
+
+/*
+Resultado de eigen_solve: los autopares y datos para comparar métodos
+*/
+struct EigenResult {
+    Eigen::VectorXd eigenvalues;
+    Matrix eigenvectors;
+    // Productos matriz-vector con la matriz (un producto por un bloque de m vectores cuenta m)
+    unsigned products;
+    // ||A v - λ v|| de cada autopar
+    Eigen::VectorXd residuals;
+    double seconds;
+};
+
+/*
+Calcula los num primeros autopares con el método indicado ("power", "subspace" o "lanczos")
+y devuelve también productos, residuos y tiempo. initial es la base desde donde arranca el método
+(ver cada uno). Otro método tira std::invalid_argument
+*/
+EigenResult eigen_solve(const MatrixRef& mat, unsigned num, const std::string& method,
+                        unsigned num_iter=1000, double epsilon=1e-10, const MatrixRef& initial=Matrix());
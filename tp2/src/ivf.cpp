@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <numeric>
+#include "ivf.h"
+#include "kmeans.h"
+#include "neighbors.h"
+#include "serialize.h"
+
+using namespace std;
+
+IVFIndex::IVFIndex()
+{
+}
+
+bool IVFIndex::empty() const
+{
+    return _offsets.empty();
+}
+
+size_t IVFIndex::lists() const
+{
+    return _centroids.rows();
+}
+
+void IVFIndex::build(const MatrixRef& X, size_t nlist, size_t iterations, unsigned int seed)
+{
+    *this = IVFIndex();
+    if (X.rows() == 0)
+    {
+        return;
+    }
+    std::vector<uint32_t> assignment;
+    _centroids = kmeans(X, nlist, iterations, seed, assignment);
+    _fillLists(X, assignment);
+}
+
+void IVFIndex::_fillLists(const MatrixRef& X, const std::vector<uint32_t>& assignment)
+{
+    size_t nlist = _centroids.rows();
+    _offsets.assign(nlist + 1, 0);
+    for (size_t i = 0; i < assignment.size(); ++i)
+    {
+        _offsets[assignment[i] + 1]++;
+    }
+    std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+
+    // Dentro de cada lista los puntos quedan en orden de índice
+    std::vector<uint32_t> next(_offsets.begin(), _offsets.end() - 1);
+    _indices.resize(assignment.size());
+    _points.resize(X.rows(), X.cols());
+    for (size_t i = 0; i < assignment.size(); ++i)
+    {
+        uint32_t position = next[assignment[i]]++;
+        _indices[position] = i;
+        _points.row(position) = X.row(i);
+    }
+    _pointNorms = _points.rowwise().squaredNorm();
+}
+
+void IVFIndex::query(const RowVector& query, size_t k, size_t nprobe, uint32_t* indices, float* distances) const
+{
+    Vector centroidDistances = (_centroids.rowwise() - query).rowwise().squaredNorm();
+    std::vector<uint32_t> order(_centroids.rows());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&centroidDistances](uint32_t a, uint32_t b) {
+        return centroidDistances(a) < centroidDistances(b) || (centroidDistances(a) == centroidDistances(b) && a < b);
+    });
+
+    NeighborHeap best(k);
+    double queryNorm = query.squaredNorm();
+    size_t candidates = 0;
+    for (size_t probe = 0; probe < order.size() && (probe < nprobe || candidates < k); ++probe)
+    {
+        uint32_t begin = _offsets[order[probe]];
+        uint32_t size = _offsets[order[probe] + 1] - begin;
+        Vector dist = _points.middleRows(begin, size) * query.transpose();
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            double d = std::max(0.0, _pointNorms(begin + i) + queryNorm - 2.0 * dist(i));
+            best.push(d, _indices[begin + i]);
+        }
+        candidates += size;
+    }
+
+    best.write(indices, distances);
+}
+
+void IVFIndex::save(std::ostream& out) const
+{
+    // Guardamos la lista de cada punto en el orden original
+    std::vector<uint32_t> assignment(_indices.size());
+    for (size_t l = 0; l + 1 < _offsets.size(); ++l)
+    {
+        for (uint32_t position = _offsets[l]; position < _offsets[l + 1]; ++position)
+        {
+            assignment[_indices[position]] = l;
+        }
+    }
+
+    writeMatrix(out, _centroids);
+    writeValue<uint64_t>(out, assignment.size());
+    out.write(reinterpret_cast<const char*>(assignment.data()), assignment.size() * sizeof(uint32_t));
+}
+
+bool IVFIndex::load(std::istream& in, const MatrixRef& X)
+{
+    uint64_t points;
+    if (!readMatrix(in, _centroids) || !readValue(in, points) || points != (uint64_t)X.rows()
+        || _centroids.cols() != X.cols())
+    {
+        *this = IVFIndex();
+        return false;
+    }
+
+    std::vector<uint32_t> assignment(points);
+    in.read(reinterpret_cast<char*>(assignment.data()), points * sizeof(uint32_t));
+    bool valid = (bool)in;
+    for (size_t i = 0; valid && i < assignment.size(); ++i)
+    {
+        valid = assignment[i] < (uint32_t)_centroids.rows();
+    }
+    if (!valid)
+    {
+        *this = IVFIndex();
+        return false;
+    }
+    _fillLists(X, assignment);
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "types.h"
+
+/*
+Índice IVF (inverted file) para búsqueda aproximada de vecinos.
+
+Los puntos se agrupan con k-means en 'nlist' listas. En cada consulta se recorren solo las
+'nprobe' listas de centroides más cercanos, así que la búsqueda es exacta dentro de esas listas
+pero puede perder vecinos que cayeron en otras. Más nprobe da más recall y más tiempo.
+Los puntos de cada lista quedan en un bloque contiguo de filas.
+*/
+class IVFIndex {
+public:
+
+    IVFIndex();
+
+    void build(const MatrixRef& X, size_t nlist, size_t iterations = 20, unsigned int seed = 0);
+
+    // Escribe en indices/distances los k vecinos encontrados en las nprobe listas más cercanas,
+    // ordenados por distancia (al cuadrado). Si esas listas tienen menos de k puntos se siguen
+    // recorriendo listas en orden de cercanía.
+    void query(const RowVector& query, size_t k, size_t nprobe, uint32_t* indices, float* distances) const;
+
+    bool empty() const;
+
+    size_t lists() const;
+
+    // Se guardan centroides y asignaciones; los puntos se vuelven a tomar de X al cargar
+    void save(std::ostream& out) const;
+    bool load(std::istream& in, const MatrixRef& X);
+
+private:
+
+    void _fillLists(const MatrixRef& X, const std::vector<uint32_t>& assignment);
+
+    Matrix _centroids;
+    // La lista l ocupa las filas [_offsets[l], _offsets[l+1]) de _points
+    std::vector<uint32_t> _offsets;
+    std::vector<uint32_t> _indices;
+    Matrix _points;
+    Vector _pointNorms;
+};
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <numeric>
+#include "kdtree.h"
+#include "neighbors.h"
+
+using namespace std;
+
+KDTree::KDTree() : _leafSize(32)
+{
+}
+
+bool KDTree::empty() const
+{
+    return _nodes.empty();
+}
+
+void KDTree::build(const MatrixRef& X, size_t leaf_size)
+{
+    _leafSize = std::max<size_t>(1, leaf_size);
+    _nodes.clear();
+    // Sin puntos no hay raíz: el árbol queda vacío y query no devuelve vecinos
+    if (X.rows() == 0)
+    {
+        _points.resize(0, X.cols());
+        _lower.resize(0, X.cols());
+        _upper.resize(0, X.cols());
+        _indices.clear();
+        return;
+    }
+    _points = X;
+    _indices.resize(X.rows());
+    std::iota(_indices.begin(), _indices.end(), 0);
+
+    size_t maxNodes = 2 * (X.rows() / _leafSize + 1);
+    _nodes.reserve(maxNodes);
+    _lower.resize(maxNodes, X.cols());
+    _upper.resize(maxNodes, X.cols());
+
+    _build(0, X.rows());
+
+    _lower.conservativeResize(_nodes.size(), X.cols());
+    _upper.conservativeResize(_nodes.size(), X.cols());
+
+    // Reordenamos los puntos según el orden de las hojas
+    Matrix points(X.rows(), X.cols());
+    for (size_t i = 0; i < _indices.size(); ++i)
+    {
+        points.row(i) = X.row(_indices[i]);
+    }
+    _points.swap(points);
+}
+
+/**
+* Construye el nodo con los puntos _indices[begin, end) y devuelve su posición.
+* Se parte por la mediana de la dimensión de mayor extensión.
+*/
+int32_t KDTree::_build(uint32_t begin, uint32_t end)
+{
+    int32_t id = _nodes.size();
+    Node node = {begin, end, -1, -1};
+    _nodes.push_back(node);
+
+    if ((size_t)id >= (size_t)_lower.rows())
+    {
+        _lower.conservativeResize(2 * _lower.rows(), _lower.cols());
+        _upper.conservativeResize(2 * _upper.rows(), _upper.cols());
+    }
+    _lower.row(id) = _points.row(_indices[begin]);
+    _upper.row(id) = _points.row(_indices[begin]);
+    for (uint32_t i = begin + 1; i < end; ++i)
+    {
+        _lower.row(id) = _lower.row(id).cwiseMin(_points.row(_indices[i]));
+        _upper.row(id) = _upper.row(id).cwiseMax(_points.row(_indices[i]));
+    }
+
+    if (end - begin <= _leafSize)
+    {
+        return id;
+    }
+
+    Eigen::Index dim;
+    (_upper.row(id) - _lower.row(id)).maxCoeff(&dim);
+    uint32_t mid = begin + (end - begin) / 2;
+    const Matrix& points = _points;
+    std::nth_element(_indices.begin() + begin, _indices.begin() + mid, _indices.begin() + end,
+                     [&points, dim](uint32_t a, uint32_t b) { return points(a, dim) < points(b, dim); });
+
+    int32_t left = _build(begin, mid);
+    int32_t right = _build(mid, end);
+    _nodes[id].left = left;
+    _nodes[id].right = right;
+    return id;
+}
+
+void KDTree::query(const RowVector& query, size_t k, uint32_t* indices, float* distances) const
+{
+    if (empty())
+    {
+        return;
+    }
+    NeighborHeap best(k);
+
+    // Distancia (al cuadrado) de la consulta a la caja de cada nodo
+    auto boxDistance = [this, &query](int32_t node) {
+        return (query - query.cwiseMax(_lower.row(node)).cwiseMin(_upper.row(node))).squaredNorm();
+    };
+
+    vector<pair<double, int32_t>> stack;
+    stack.push_back(make_pair(boxDistance(0), 0));
+    while (!stack.empty())
+    {
+        double nodeDistance = stack.back().first;
+        const Node& node = _nodes[stack.back().second];
+        stack.pop_back();
+
+        if (best.full() && nodeDistance > best.worst())
+        {
+            continue;
+        }
+
+        if (node.left < 0)
+        {
+            for (uint32_t i = node.begin; i < node.end; ++i)
+            {
+                best.push((_points.row(i) - query).squaredNorm(), _indices[i]);
+            }
+            continue;
+        }
+
+        // Apilamos primero el hijo más lejano para visitar antes el más cercano
+        double leftDistance = boxDistance(node.left);
+        double rightDistance = boxDistance(node.right);
+        if (leftDistance <= rightDistance)
+        {
+            stack.push_back(make_pair(rightDistance, node.right));
+            stack.push_back(make_pair(leftDistance, node.left));
+        }
+        else
+        {
+            stack.push_back(make_pair(leftDistance, node.left));
+            stack.push_back(make_pair(rightDistance, node.right));
+        }
+    }
+
+    best.write(indices, distances);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "types.h"
+
+/*
+KD-tree para búsqueda exacta de los k vecinos más cercanos.
+
+Los nodos se guardan en un arreglo contiguo y los puntos se reordenan para que cada hoja
+sea un bloque consecutivo de filas. Cada nodo guarda su caja envolvente, y en la búsqueda
+se descartan los nodos cuya caja está más lejos que el k-ésimo vecino encontrado hasta el momento.
+*/
+class KDTree {
+public:
+
+    KDTree();
+
+    void build(const MatrixRef& X, size_t leaf_size = 32);
+
+    // Escribe en indices/distances los k vecinos más cercanos a 'query' ordenados por distancia
+    // (al cuadrado). A igual distancia desempata el índice, igual que la búsqueda por fuerza bruta.
+    // Escribe min(k, puntos) vecinos; en un árbol vacío no escribe nada
+    void query(const RowVector& query, size_t k, uint32_t* indices, float* distances) const;
+
+    bool empty() const;
+
+private:
+
+    struct Node {
+        uint32_t begin;
+        uint32_t end;
+        int32_t left;
+        int32_t right;
+    };
+
+    int32_t _build(uint32_t begin, uint32_t end);
+
+    size_t _leafSize;
+    std::vector<Node> _nodes;
+    // Caja envolvente de cada nodo, una fila por nodo
+    Matrix _lower;
+    Matrix _upper;
+    // Puntos reordenados y el índice original de cada uno
+    Matrix _points;
+    std::vector<uint32_t> _indices;
+};
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include "kmeans.h"
+
+using namespace std;
+
+// Filas de X que se asignan juntas con un producto de matrices
+static const Eigen::Index ASSIGN_ROWS = 256;
+
+Matrix kmeans(const MatrixRef& X, size_t k, size_t iterations, unsigned int seed, std::vector<uint32_t>& assignment)
+{
+    assignment.resize(X.rows());
+    if (X.rows() == 0)
+    {
+        return Matrix(0, X.cols());
+    }
+    k = std::max<size_t>(1, std::min<size_t>(k, X.rows()));
+    std::mt19937 generator(seed);
+
+    // Centroides iniciales: k puntos distintos elegidos al azar
+    std::vector<uint32_t> sample(X.rows());
+    std::iota(sample.begin(), sample.end(), 0);
+    std::shuffle(sample.begin(), sample.end(), generator);
+    Matrix centroids(k, X.cols());
+    for (size_t c = 0; c < k; ++c)
+    {
+        centroids.row(c) = X.row(sample[c]);
+    }
+
+    std::uniform_int_distribution<uint32_t> randomRow(0, X.rows() - 1);
+    for (size_t it = 0; it < iterations; ++it)
+    {
+        assign_to_centroids(X, centroids, assignment);
+
+        Matrix sums = Matrix::Zero(k, X.cols());
+        std::vector<size_t> counts(k, 0);
+        for (Eigen::Index i = 0; i < X.rows(); ++i)
+        {
+            sums.row(assignment[i]) += X.row(i);
+            counts[assignment[i]]++;
+        }
+        for (size_t c = 0; c < k; ++c)
+        {
+            // Un centroide sin puntos se reinicia en un punto al azar
+            if (counts[c] == 0)
+            {
+                centroids.row(c) = X.row(randomRow(generator));
+            }
+            else
+            {
+                centroids.row(c) = sums.row(c) / counts[c];
+            }
+        }
+    }
+
+    assign_to_centroids(X, centroids, assignment);
+    return centroids;
+}
+
+/**
+* Como en KNN, el término cruzado de ||x - c||² se calcula con un producto de matrices
+* por bloque de filas; ||x||² no cambia el mínimo.
+*/
+void assign_to_centroids(const MatrixRef& X, const Matrix& centroids, std::vector<uint32_t>& assignment)
+{
+    assignment.resize(X.rows());
+    Vector centroidNorms = centroids.rowwise().squaredNorm();
+    Eigen::Index tiles = (X.rows() + ASSIGN_ROWS - 1) / ASSIGN_ROWS;
+    #pragma omp parallel for schedule(dynamic)
+    for (Eigen::Index tile = 0; tile < tiles; ++tile)
+    {
+        Eigen::Index first = tile * ASSIGN_ROWS;
+        Eigen::Index rows = std::min(ASSIGN_ROWS, X.rows() - first);
+        Matrix dist = X.middleRows(first, rows) * centroids.transpose();
+        dist *= -2.0;
+        dist.rowwise() += centroidNorms.transpose();
+        for (Eigen::Index i = 0; i < rows; ++i)
+        {
+            Eigen::Index closest;
+            dist.row(i).minCoeff(&closest);
+            assignment[first + i] = closest;
+        }
+    }
+}
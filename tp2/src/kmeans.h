@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+#include "types.h"
+
+// k-means de Lloyd con centroides iniciales elegidos al azar entre las filas de X.
+// Devuelve los centroides (una fila cada uno) y deja en assignment el centroide de cada fila de X
+Matrix kmeans(const MatrixRef& X, size_t k, size_t iterations, unsigned int seed, std::vector<uint32_t>& assignment);
+
+// Asigna cada fila de X al centroide más cercano (en paralelo por bloques de filas)
+void assign_to_centroids(const MatrixRef& X, const Matrix& centroids, std::vector<uint32_t>& assignment);
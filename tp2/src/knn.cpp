@@ -1,92 +1,607 @@
 #include <algorithm>
-//#include <chrono>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
-#include <map>
+#include <numeric>
+#include <stdexcept>
 #include "knn.h"
+#include "serialize.h"
 
 using namespace std;
 
+const Eigen::Index KNNClassifier::TILE_ROWS;
+const Eigen::Index KNNClassifier::KD_TREE_MAX_DIMS;
 
-KNNClassifier::KNNClassifier(unsigned int n_neighbors) : _k(n_neighbors), _sortedNearestNeighbors()
+// Versión del formato de save/load
+static const uint32_t MODEL_VERSION = 4;
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Norma al cuadrado de cada fila, recorriendo solo los no nulos
+static Vector squared_norms(const SparseMatrix& X)
+{
+    Vector norms = Vector::Zero(X.rows());
+    for (Eigen::Index i = 0; i < X.outerSize(); ++i)
+    {
+        for (SparseMatrix::InnerIterator it(X, i); it; ++it)
+        {
+            norms(i) += it.value() * it.value();
+        }
+    }
+    return norms;
+}
+
+// ||x - q||² = ||x||² + ||q||² - 2 x·q a partir de los productos cruzados consulta x entrenamiento
+static Matrix squared_distances(Matrix cross, const Vector& trainNorms, const Vector& queryNorms)
+{
+    cross *= -2.0;
+    cross.rowwise() += trainNorms.transpose();
+    cross.colwise() += queryNorms;
+    // Por redondeo pueden quedar valores levemente negativos
+    return cross.cwiseMax(0.0);
+}
+
+static bool valid_algorithm(const std::string& algorithm)
+{
+    return algorithm == "brute" || algorithm == "kd_tree" || algorithm == "ivf" || algorithm == "auto";
+}
+
+static bool valid_storage(const std::string& storage)
+{
+    return storage == "double" || storage == "float" || storage == "uint8" || storage == "pq";
+}
+
+static bool valid_weights(const std::string& weights)
+{
+    return weights == "uniform" || weights == "distance";
+}
+
+
+KNNClassifier::KNNClassifier(unsigned int n_neighbors, unsigned int k_max, const std::string& algorithm,
+                             unsigned int nlist, unsigned int nprobe, const std::string& storage,
+                             unsigned int pq_subspaces, const std::string& weights)
+    : _k(n_neighbors), _kMax(std::max(n_neighbors, k_max)), _algorithm(algorithm), _nlist(nlist), _nprobe(nprobe),
+      _storage(storage), _pqSubspaces(pq_subspaces), _weights(weights), _sparse(false), _nearestNeighbors(), _nearestDistances(),
+      _timings{0.0, 0.0, 0.0}
 {
+    if (!valid_algorithm(_algorithm))
+    {
+        throw std::invalid_argument("KNNClassifier: algorithm tiene que ser \"brute\", \"kd_tree\", \"ivf\" o \"auto\"");
+    }
+    if (!valid_storage(_storage))
+    {
+        throw std::invalid_argument("KNNClassifier: storage tiene que ser \"double\", \"float\", \"uint8\" o \"pq\"");
+    }
+    if (!valid_weights(_weights))
+    {
+        throw std::invalid_argument("KNNClassifier: weights tiene que ser \"uniform\" o \"distance\"");
+    }
+}
+
+void KNNClassifier::fit(const MatrixRef& X, const IntVector& y)
+{
+    _fit(X, y, true);
+}
+
+void KNNClassifier::fitNoCopy(const MatrixRef& X, const IntVector& y)
+{
+    _fit(X, y, false);
 }
 
-void KNNClassifier::fit(const Matrix& X, const IntVector& y)
+void KNNClassifier::_fit(const MatrixRef& X, const IntVector& y, bool copy)
 {
-    _X = X;
     _y = y;
+    _remapLabels();
+    _storeTraining(X, copy);
+
+    _ivf = IVFIndex();
+    if (_algorithm == "ivf" && _storage == "double")
+    {
+        size_t nlist = _nlist > 0 ? _nlist : (size_t)std::sqrt((double)_y.rows());
+        _ivf.build(_train(), nlist);
+    }
+    _buildIndex();
+}
+
+void KNNClassifier::fitSparse(const SparseMatrix& X, const IntVector& y)
+{
+    _y = y;
+    _remapLabels();
+    _clearTraining();
+    _Xs = X;
+    _Xs.makeCompressed();
+    _sparse = true;
+    _trainSquaredNorms = squared_norms(_Xs);
+
+    _ivf = IVFIndex();
+    _buildIndex();
+}
+
+void KNNClassifier::_clearTraining()
+{
+    _X.resize(0, 0);
+    _external.reset();
+    _trainSquaredNorms.resize(0);
+    _Xf.resize(0, 0);
+    _trainSquaredNormsF.resize(0);
+    _codes.resize(0, 0);
+    _Xs = SparseMatrix();
+    _sparse = false;
+}
+
+void KNNClassifier::_storeTraining(const MatrixRef& X, bool copy)
+{
+    _clearTraining();
+
+    if (_storage == "float")
+    {
+        _Xf = X.cast<float>();
+        _trainSquaredNormsF = _Xf.rowwise().squaredNorm();
+    }
+    else if (_storage == "uint8")
+    {
+        _scalarQuantizer.fit(X);
+        _codes = _scalarQuantizer.encode(X);
+    }
+    else if (_storage == "pq")
+    {
+        size_t subspaces = _pqSubspaces > 0 ? _pqSubspaces : std::max<size_t>(1, X.cols() / 8);
+        _productQuantizer.fit(X, subspaces);
+        _codes = _productQuantizer.encode(X);
+    }
+    else
+    {
+        if (copy)
+        {
+            _X = X;
+        }
+        else
+        {
+            _external = std::make_shared<MatrixMap>(X.data(), X.rows(), X.cols(), Eigen::OuterStride<>(X.outerStride()));
+        }
+        _trainSquaredNorms = X.rowwise().squaredNorm();
+    }
+}
+
+void KNNClassifier::_remapLabels()
+{
+    _labels.assign(_y.data(), _y.data() + _y.size());
+    std::sort(_labels.begin(), _labels.end());
+    _labels.erase(std::unique(_labels.begin(), _labels.end()), _labels.end());
+
+    _classes.resize(_y.size());
+    for (Eigen::Index i = 0; i < _y.size(); ++i)
+    {
+        _classes[i] = std::lower_bound(_labels.begin(), _labels.end(), _y(i)) - _labels.begin();
+    }
+}
+
+KNNClassifier::MatrixMap KNNClassifier::_train() const
+{
+    if (_external)
+    {
+        return *_external;
+    }
+    return MatrixMap(_X.data(), _X.rows(), _X.cols(), Eigen::OuterStride<>(_X.cols()));
+}
+
+size_t KNNClassifier::trainMemory() const
+{
+    size_t sparse = _sparse ? _Xs.nonZeros() * (sizeof(double) + sizeof(SparseMatrix::StorageIndex))
+                                  + (_Xs.outerSize() + 1) * sizeof(SparseMatrix::StorageIndex)
+                            : 0;
+    return _X.size() * sizeof(double) + _Xf.size() * sizeof(float) + _codes.size() * sizeof(uint8_t) + sparse;
+}
+
+// El KD-tree se construye rápido, así que no se guarda y se arma de nuevo también en load
+void KNNClassifier::_buildIndex()
+{
+    _tree = KDTree();
+    bool useTree = !_sparse && _storage == "double"
+        && (_algorithm == "kd_tree" || (_algorithm == "auto" && _train().cols() <= KD_TREE_MAX_DIMS));
+    if (useTree)
+    {
+        _tree.build(_train());
+    }
+}
+
+std::string KNNClassifier::algorithm() const
+{
+    if (!_ivf.empty())
+    {
+        return "ivf";
+    }
+    return _tree.empty() ? "brute" : "kd_tree";
+}
+
+void KNNClassifier::setNProbe(unsigned int nprobe)
+{
+    _nprobe = nprobe;
+}
+
+const IndexMatrix& KNNClassifier::neighbors() const
+{
+    return _nearestNeighbors;
 }
 
 /**
-* Devuelve un vector con la distancia al cuadrado de 'row' con respecto a cada elemento del entrenamiento
+* Devuelve una matriz con la distancia al cuadrado de cada fila de 'queries' (filas) a cada elemento
+* del entrenamiento (columnas), usando ||x - q||² = ||x||² + ||q||² - 2 x·q.
+* El término cruzado es un único producto de matrices para todo el bloque.
 */
-Vector KNNClassifier::_distanceToRow(const RowVector& row)
+Matrix KNNClassifier::_distancesToTile(const MatrixRef& queries)
 {
-    auto ret = Vector(_X.rows());
-    for (Eigen::Index i = 0; i < _X.rows(); ++i)
+    if (_sparse)
     {
-        ret(i) = (_X.row(i) - row).squaredNorm();
+        return squared_distances(queries * _Xs.transpose(), _trainSquaredNorms, queries.rowwise().squaredNorm());
     }
-    return ret;
+    if (_storage == "float")
+    {
+        FloatMatrix floatQueries = queries.cast<float>();
+        FloatMatrix ret = floatQueries * _Xf.transpose();
+        ret *= -2.0f;
+        ret.rowwise() += _trainSquaredNormsF.transpose();
+        ret.colwise() += floatQueries.rowwise().squaredNorm();
+        return ret.cwiseMax(0.0f).cast<double>();
+    }
+    if (_storage == "uint8")
+    {
+        return _scalarQuantizer.distances(_scalarQuantizer.encode(queries), _codes);
+    }
+    if (_storage == "pq")
+    {
+        return _productQuantizer.distances(queries, _codes);
+    }
+
+    return squared_distances(queries * _train().transpose(), _trainSquaredNorms, queries.rowwise().squaredNorm());
 }
 
 /**
-* Predice el dígito utilizando KNN
+* Igual que para consultas densas, pero x·q es un producto ralo: por denso si el entrenamiento es
+* "double" y ralo por ralo si vino de fitSparse. Los demás storages comparan consultas densas, así
+* que solo para ellos se arma densa la tile (TILE_ROWS filas), nunca toda la matriz.
 */
-size_t KNNClassifier::_predictRow(const RowVector& row)
+Matrix KNNClassifier::_distancesToTile(const SparseMatrix& queries)
 {
-    auto dist = _distanceToRow(row);
+    if (_sparse)
+    {
+        return squared_distances(queries * _Xs.transpose(), _trainSquaredNorms, squared_norms(queries));
+    }
+    if (_storage == "double")
+    {
+        return squared_distances(queries * _train().transpose(), _trainSquaredNorms, squared_norms(queries));
+    }
+    return _distancesToTile(Matrix(queries));
+}
 
+/**
+* Guarda los k_max vecinos más cercanos de la consulta a partir de las distancias a cada elemento del
+* entrenamiento. Solo se ordenan esos k_max: nth_element los separa en O(n) y después se ordenan entre ellos.
+*/
+void KNNClassifier::_selectRow(const RowVector& dist, Eigen::Index query)
+{
     size_t n = 0;
-    IntVector neighbors(_X.rows());
-    std::generate(neighbors.data(), neighbors.data() + neighbors.size(), [&n] { return n++; });
-    std::sort(neighbors.data(), neighbors.data() + neighbors.size(),
-              [&dist](int i1, int i2) { return dist(i1) < dist(i2); });
+    std::vector<size_t> candidates(_y.rows());
+    std::generate(candidates.begin(), candidates.end(), [&n] { return n++; });
 
-    _sortedNearestNeighbors.push_back(neighbors);
+    // A igual distancia desempata el índice, para que el resultado no dependa del algoritmo de selección
+    auto closer = [&dist](size_t i1, size_t i2) {
+        return dist(i1) < dist(i2) || (dist(i1) == dist(i2) && i1 < i2);
+    };
+    size_t kMax = _nearestNeighbors.cols();
+    std::nth_element(candidates.begin(), candidates.begin() + kMax, candidates.end(), closer);
+    std::sort(candidates.begin(), candidates.begin() + kMax, closer);
 
-    return _predict_cached_row(neighbors, _k);
+    for (size_t i = 0; i < kMax; ++i) {
+        _nearestNeighbors(query, i) = candidates[i];
+        _nearestDistances(query, i) = dist(candidates[i]);
+    }
 }
 
-size_t KNNClassifier::_predict_cached_row(IntVector distances, size_t new_k){
-    std::map<size_t, size_t> neighborScore;
+size_t KNNClassifier::_predict_cached_row(Eigen::Index query, size_t k) const
+{
+    size_t label;
+    _vote(query, &k, 1, &label);
+    return label;
+}
 
-    for (size_t i = 0; i < new_k; ++i) {
-        neighborScore[_y(distances(i))]++;
+/**
+* Los vecinos se recorren en orden de distancia sumando su voto en el histograma de clases. Solo
+* cambia el puntaje de la clase del vecino que se suma, así que el ganador es el anterior o esa
+* clase; a igual puntaje gana la que apareció primero, es decir la del vecino más cercano.
+*/
+void KNNClassifier::_vote(Eigen::Index query, const size_t* ks, size_t count, size_t* labels) const
+{
+    size_t available = _nearestNeighbors.cols();
+    if (available == 0)
+    {
+        std::fill(labels, labels + count, 0);
+        return;
     }
 
-    auto res = std::max_element(neighborScore.begin(), neighborScore.end(),
-                                [](const std::pair<double, int> &a, const std::pair<double, int> &b) -> bool
-                                {
-                                    return a.second < b.second;
-                                });
-
-    return res->first;
+    std::vector<double> scores(_labels.size(), 0.0);
+    std::vector<size_t> first(_labels.size(), available);
+    bool weighted = _weights == "distance";
+    size_t best = _classes[_nearestNeighbors(query, 0)];
+    size_t counted = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t k = std::max<size_t>(1, std::min(ks[i], available));
+        for (; counted < k; ++counted)
+        {
+            size_t c = _classes[_nearestNeighbors(query, counted)];
+            // Las distancias guardadas son al cuadrado; un vecino a distancia 0 le gana a todos los demás
+            scores[c] += weighted ? 1.0 / std::max(std::sqrt((double)_nearestDistances(query, counted)), 1e-12) : 1.0;
+            first[c] = std::min(first[c], counted);
+            if (scores[c] > scores[best] || (scores[c] == scores[best] && first[c] < first[best]))
+            {
+                best = c;
+            }
+        }
+        labels[i] = _labels[best];
+    }
 }
 
 IntVector KNNClassifier::predictWithK(size_t k_neighbors) {
     // Creamos el vector columna a devolver
-    auto ret = IntVector(_sortedNearestNeighbors.size());
-    
-    for (size_t i = 0; i < _sortedNearestNeighbors.size(); ++i)
+    auto ret = IntVector(_nearestNeighbors.rows());
+
+    #pragma omp parallel for
+    for (Eigen::Index i = 0; i < _nearestNeighbors.rows(); ++i)
+    {
+        ret(i) = _predict_cached_row(i, k_neighbors);
+    }
+
+    return ret;
+}
+
+IntMatrix KNNClassifier::predictWithKs(const IntVector& ks)
+{
+    std::vector<size_t> order(ks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&ks](size_t a, size_t b) { return ks(a) < ks(b); });
+    std::vector<size_t> sorted(ks.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        sorted[i] = ks(order[i]);
+    }
+
+    IntMatrix ret(_nearestNeighbors.rows(), ks.size());
+    #pragma omp parallel for
+    for (Eigen::Index i = 0; i < _nearestNeighbors.rows(); ++i)
     {
-        size_t result = _predict_cached_row(_sortedNearestNeighbors[i], k_neighbors);
-        ret(i) = result;
+        std::vector<size_t> labels(sorted.size());
+        _vote(i, sorted.data(), sorted.size(), labels.data());
+        for (size_t j = 0; j < order.size(); ++j)
+        {
+            ret(i, order[j]) = labels[j];
+        }
     }
 
     return ret;
 }
 
-IntVector KNNClassifier::predict(const Matrix& X)
+size_t KNNClassifier::cacheMemory() const
 {
+    return _nearestNeighbors.size() * sizeof(uint32_t) + _nearestDistances.size() * sizeof(float);
+}
+
+IntVector KNNClassifier::predict(const MatrixRef& X)
+{
+    return _predict(X);
+}
+
+IntVector KNNClassifier::predictSparse(const SparseMatrix& X)
+{
+    return _predict(X);
+}
+
+// Queries es MatrixRef o SparseMatrix: cambia solo cómo se calculan las distancias de cada tile
+template<typename Queries>
+IntVector KNNClassifier::_predict(const Queries& X)
+{
+    // Sin entrenamiento no hay vecinos: se devuelve un vector vacío en lugar de etiquetas inventadas
+    if (_y.rows() == 0)
+    {
+        _nearestNeighbors.resize(0, 0);
+        _nearestDistances.resize(0, 0);
+        _timings = {0.0, 0.0, 0.0};
+        return IntVector(0);
+    }
+
     // Creamos vector columna a devolver
-    _sortedNearestNeighbors.clear();
+    Eigen::Index kMax = std::min((Eigen::Index)_kMax, _y.rows());
+    _nearestNeighbors.resize(X.rows(), kMax);
+    _nearestDistances.resize(X.rows(), kMax);
     auto ret = IntVector(X.rows());
+    size_t k = std::min(_k, (size_t)kMax);
+    double distances = 0.0, selection = 0.0, vote = 0.0;
 
-    for (Eigen::Index i = 0; i < X.rows(); ++i)
+    if (!_ivf.empty() || !_tree.empty())
     {
-        ret(i) = _predictRow(X.row(i));
+        #pragma omp parallel for schedule(dynamic, 16) reduction(+:distances, vote)
+        for (Eigen::Index i = 0; i < X.rows(); ++i)
+        {
+            Clock::time_point start = Clock::now();
+            if (!_ivf.empty())
+            {
+                _ivf.query(RowVector(X.row(i)), kMax, _nprobe, &_nearestNeighbors(i, 0), &_nearestDistances(i, 0));
+            }
+            else
+            {
+                _tree.query(RowVector(X.row(i)), kMax, &_nearestNeighbors(i, 0), &_nearestDistances(i, 0));
+            }
+            Clock::time_point searched = Clock::now();
+            ret(i) = _predict_cached_row(i, k);
+            distances += seconds(start, searched);
+            vote += seconds(searched, Clock::now());
+        }
+        _timings = {distances, selection, vote};
+        return ret;
     }
 
+    // Cada bloque de consultas es independiente y escribe solo sus filas de ret y del cache
+    Eigen::Index tiles = (X.rows() + TILE_ROWS - 1) / TILE_ROWS;
+    #pragma omp parallel for schedule(dynamic) reduction(+:distances, selection, vote)
+    for (Eigen::Index tile = 0; tile < tiles; ++tile)
+    {
+        Eigen::Index first = tile * TILE_ROWS;
+        Eigen::Index rows = std::min(TILE_ROWS, X.rows() - first);
+        Clock::time_point start = Clock::now();
+        Matrix dist = _distancesToTile(X.middleRows(first, rows));
+        Clock::time_point computed = Clock::now();
+        for (Eigen::Index i = 0; i < rows; ++i)
+        {
+            _selectRow(dist.row(i), first + i);
+        }
+        Clock::time_point selected = Clock::now();
+        for (Eigen::Index i = 0; i < rows; ++i)
+        {
+            ret(first + i) = _predict_cached_row(first + i, k);
+        }
+        distances += seconds(start, computed);
+        selection += seconds(computed, selected);
+        vote += seconds(selected, Clock::now());
+    }
+
+    _timings = {distances, selection, vote};
     return ret;
 }
+
+const KNNTimings& KNNClassifier::timings() const
+{
+    return _timings;
+}
+
+/**
+* Guarda los parámetros, las etiquetas, los datos de entrenamiento y el índice IVF si hay.
+* Formato: "KNN1", versión, parámetros, etiquetas y, un byte que indica si el entrenamiento es ralo,
+* el entrenamiento (ralo, o en el storage elegido si no) y el índice IVF precedido de un byte que
+* indica si existe.
+*/
+bool KNNClassifier::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write("KNN1", 4);
+    writeValue<uint32_t>(out, MODEL_VERSION);
+    writeValue<uint64_t>(out, _k);
+    writeValue<uint64_t>(out, _kMax);
+    writeString(out, _algorithm);
+    writeValue<uint64_t>(out, _nlist);
+    writeValue<uint64_t>(out, _nprobe);
+    writeString(out, _storage);
+    writeValue<uint64_t>(out, _pqSubspaces);
+    writeString(out, _weights);
+    writeMatrix(out, _y);
+    writeValue<uint8_t>(out, _sparse);
+
+    if (_sparse)
+    {
+        writeSparse(out, _Xs);
+    }
+    else if (_storage == "float")
+    {
+        writeMatrix(out, _Xf);
+    }
+    else if (_storage == "uint8")
+    {
+        _scalarQuantizer.save(out);
+        writeMatrix(out, _codes);
+    }
+    else if (_storage == "pq")
+    {
+        _productQuantizer.save(out);
+        writeMatrix(out, _codes);
+    }
+    else
+    {
+        if (_external)
+        {
+            writeMatrix(out, Matrix(*_external));
+        }
+        else
+        {
+            writeMatrix(out, _X);
+        }
+    }
+
+    writeValue<uint8_t>(out, !_ivf.empty());
+    if (!_ivf.empty())
+    {
+        _ivf.save(out);
+    }
+    return (bool)out;
+}
+
+bool KNNClassifier::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t version;
+    uint64_t k, kMax, nlist, nprobe, pqSubspaces;
+    std::string algorithm, storage, weights;
+    if (!in.read(magic, 4) || std::string(magic, 4) != "KNN1"
+        || !readValue(in, version) || version != MODEL_VERSION
+        || !readValue(in, k) || !readValue(in, kMax) || !readString(in, algorithm)
+        || !readValue(in, nlist) || !readValue(in, nprobe)
+        || !readString(in, storage) || !readValue(in, pqSubspaces) || !readString(in, weights)
+        || !valid_algorithm(algorithm) || !valid_storage(storage)
+        || !valid_weights(weights))
+    {
+        return false;
+    }
+
+    // Se lee todo en un modelo nuevo para no dejar este a medio cargar si el archivo está mal
+    KNNClassifier model(k, kMax, algorithm, nlist, nprobe, storage, pqSubspaces, weights);
+    Eigen::Index rows;
+    uint8_t sparse = 0;
+    bool valid = readMatrix(in, model._y) && readValue(in, sparse);
+    model._remapLabels();
+    if (sparse)
+    {
+        valid = valid && readSparse(in, model._Xs);
+        model._sparse = true;
+        model._trainSquaredNorms = squared_norms(model._Xs);
+        rows = model._Xs.rows();
+    }
+    else if (model._storage == "float")
+    {
+        valid = valid && readMatrix(in, model._Xf);
+        model._trainSquaredNormsF = model._Xf.rowwise().squaredNorm();
+        rows = model._Xf.rows();
+    }
+    else if (model._storage == "uint8")
+    {
+        valid = valid && model._scalarQuantizer.load(in) && readMatrix(in, model._codes);
+        rows = model._codes.rows();
+    }
+    else if (model._storage == "pq")
+    {
+        valid = valid && model._productQuantizer.load(in) && readMatrix(in, model._codes)
+            && model._codes.cols() == (Eigen::Index)model._productQuantizer.subspaces();
+        rows = model._codes.rows();
+    }
+    else
+    {
+        valid = valid && readMatrix(in, model._X);
+        model._trainSquaredNorms = model._X.rowwise().squaredNorm();
+        rows = model._X.rows();
+    }
+
+    uint8_t hasIVF = 0;
+    valid = valid && rows == model._y.rows() && readValue(in, hasIVF);
+    if (!valid || (hasIVF && !model._ivf.load(in, model._X)))
+    {
+        return false;
+    }
+
+    model._buildIndex();
+    *this = model;
+    return true;
+}
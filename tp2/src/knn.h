@@ -1,30 +1,152 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
 #include "types.h"
+#include "kdtree.h"
+#include "ivf.h"
+#include "quantization.h"
 
+// Segundos de cada etapa del último predict, sumados entre los threads. Con kd_tree e ivf la
+// búsqueda completa cuenta como distancias y la selección queda en 0
+struct KNNTimings {
+    double distances;
+    double selection;
+    double vote;
+};
 
 class KNNClassifier {
 public:
 
-    KNNClassifier(unsigned int n_neighbors);
+    // k_max: cantidad de vecinos que se guardan por consulta para predictWithK (como mínimo n_neighbors)
+    // algorithm: "brute" (fuerza bruta), "kd_tree" o "auto" (kd_tree si la dimensión es a lo sumo KD_TREE_MAX_DIMS)
+    //            son exactos; "ivf" es aproximado y nunca se elige con "auto"; otro nombre tira
+    //            std::invalid_argument
+    // nlist: cantidad de listas del índice IVF (0 usa sqrt(n)); nprobe: listas que se recorren por consulta
+    // storage: cómo se guarda el entrenamiento para la fuerza bruta: "double", "float", "uint8"
+    //          (cuantización escalar; exacta si los datos son enteros con rango a lo sumo 255,
+    //          como los píxeles sin normalizar) o "pq" (product quantization con
+    //          pq_subspaces bytes por fila; 0 usa uno cada 8 columnas). kd_tree e ivf necesitan
+    //          "double": con otro storage se usa fuerza bruta. Otro valor tira std::invalid_argument
+    // weights: "uniform" (un voto por vecino) o "distance" (cada voto pesa la inversa de la distancia).
+    //          A igual puntaje gana la etiqueta del vecino más cercano. Otro valor tira std::invalid_argument
+    KNNClassifier(unsigned int n_neighbors, unsigned int k_max = 0, const std::string& algorithm = "auto",
+                  unsigned int nlist = 0, unsigned int nprobe = 8,
+                  const std::string& storage = "double", unsigned int pq_subspaces = 0,
+                  const std::string& weights = "uniform");
+
+    void fit(const MatrixRef& X, const IntVector& y);
+
+    // Como fit pero guarda una referencia a X en lugar de copiarlo, así que X no puede cambiar
+    // ni liberarse mientras se use el clasificador. Solo evita la copia con storage "double";
+    // kd_tree e ivf igual arman su propia copia reordenada
+    void fitNoCopy(const MatrixRef& X, const IntVector& y);
 
-    void fit(const Matrix& X, const IntVector& y);
+    // fit con el entrenamiento ralo (por ejemplo scipy.sparse.csr_matrix). Se guarda ralo, sin
+    // importar storage, y las distancias salen de productos ralos y las normas guardadas; usa
+    // siempre fuerza bruta
+    void fitSparse(const SparseMatrix& X, const IntVector& y);
 
-    IntVector predict(const Matrix& X);
+    // Si se entrenó sin filas devuelve un vector vacío (y predictWithK también, porque vacía el cache)
+    IntVector predict(const MatrixRef& X);
 
+    // predict con consultas ralas; sirve tanto si se entrenó con fit como con fitSparse
+    IntVector predictSparse(const SparseMatrix& X);
+
+    // Usa los vecinos guardados en el último predict. Si k_neighbors supera a k_max se usan los k_max guardados
     IntVector predictWithK(size_t k_neighbors);
 
+    // predictWithK para cada k de ks (columna i de la respuesta para ks(i)), votando una sola vez
+    // por consulta: los vecinos se suman de a uno y se lee el ganador al llegar a cada k
+    IntMatrix predictWithKs(const IntVector& ks);
+
+    // Bytes ocupados por los vecinos guardados para predictWithK
+    size_t cacheMemory() const;
+
+    // Bytes ocupados por el entrenamiento guardado en fit
+    size_t trainMemory() const;
+
+    // Algoritmo elegido en el último fit: "brute", "kd_tree" o "ivf"
+    std::string algorithm() const;
+
+    // Permite cambiar el compromiso recall/velocidad del IVF sin volver a construir el índice
+    void setNProbe(unsigned int nprobe);
+
+    // Tiempo de cada etapa del último predict
+    const KNNTimings& timings() const;
+
+    // Vecinos guardados en el último predict, una fila por consulta
+    const IndexMatrix& neighbors() const;
+
+    // Guarda el entrenamiento y el índice IVF (si hay) para no volver a correr k-means.
+    // Devuelven false si no se pudo escribir o leer el archivo
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // A partir de esta dimensión el KD-tree casi no descarta nodos y conviene fuerza bruta
+    static const Eigen::Index KD_TREE_MAX_DIMS = 32;
+
 private:
 
-    Vector _distanceToRow(const RowVector& row);
+    // Cantidad de consultas que se procesan juntas en cada bloque de distancias
+    static const Eigen::Index TILE_ROWS = 64;
+
+    Matrix _distancesToTile(const MatrixRef& queries);
+    Matrix _distancesToTile(const SparseMatrix& queries);
+
+    template<typename Queries>
+    IntVector _predict(const Queries& X);
+
+    void _selectRow(const RowVector& distances, Eigen::Index query);
+    size_t _predict_cached_row(Eigen::Index query, size_t k) const;
+    // Escribe en labels[i] la etiqueta ganadora con los primeros ks[i] vecinos guardados de la consulta.
+    // ks tiene que estar ordenado de menor a mayor
+    void _vote(Eigen::Index query, const size_t* ks, size_t count, size_t* labels) const;
+    void _remapLabels();
 
-    size_t _predictRow(const RowVector& row);
-    size_t _predict_cached_row(IntVector, size_t);
+    typedef Eigen::Map<const Matrix, 0, Eigen::OuterStride<>> MatrixMap;
+
+    void _fit(const MatrixRef& X, const IntVector& y, bool copy);
+    void _storeTraining(const MatrixRef& X, bool copy);
+    void _clearTraining();
+    // Entrenamiento en double: _X o el arreglo externo de fitNoCopy
+    MatrixMap _train() const;
+    void _buildIndex();
 
     size_t _k;
-    Matrix _X;
+    size_t _kMax;
+    std::string _algorithm;
+    size_t _nlist;
+    size_t _nprobe;
+    std::string _storage;
+    size_t _pqSubspaces;
+    std::string _weights;
+    KDTree _tree;
+    IVFIndex _ivf;
     IntVector _y;
+    // Etiquetas distintas de _y ordenadas, y para cada elemento del entrenamiento la posición de
+    // su etiqueta ahí: los votos se cuentan en un arreglo de _labels.size() posiciones
+    std::vector<size_t> _labels;
+    std::vector<uint32_t> _classes;
+
+    // Solo se llena la representación del storage elegido
+    Matrix _X;
+    std::shared_ptr<MatrixMap> _external;
+    Vector _trainSquaredNorms;
+    FloatMatrix _Xf;
+    Eigen::VectorXf _trainSquaredNormsF;
+    ScalarQuantizer _scalarQuantizer;
+    ProductQuantizer _productQuantizer;
+    ByteMatrix _codes;
+    // Entrenamiento de fitSparse; con _sparse en true las demás representaciones están vacías
+    SparseMatrix _Xs;
+    bool _sparse;
+
+    // Para cada consulta del último predict, los k_max vecinos más cercanos ordenados por distancia
+    IndexMatrix _nearestNeighbors;
+    FloatMatrix _nearestDistances;
 
-    std::vector< IntVector > _sortedNearestNeighbors;
+    KNNTimings _timings;
 
 };
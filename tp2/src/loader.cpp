@@ -0,0 +1,242 @@
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "loader.h"
+#include "serialize.h"
+
+using namespace std;
+
+// Encabezado del formato binario: "TP2B", versión (uint32), filas y columnas (uint64). Son 24
+// bytes, así que los coeficientes quedan alineados a 8 dentro del archivo y de su mmap
+static const char BINARY_MAGIC[] = "TP2B";
+static const uint32_t BINARY_VERSION = 1;
+static const size_t BINARY_HEADER = 4 + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+// Línea vacía (por ejemplo la última del archivo, o solo el \r de un fin de línea de Windows)
+static bool blank(const std::string& line)
+{
+    return line.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+// Separa una línea de CSV en números; devuelve false si algún campo no es un número
+static bool parse_csv_line(const std::string& line, std::vector<double>& values)
+{
+    values.clear();
+    const char* position = line.c_str();
+    while (*position != '\0' && *position != '\r')
+    {
+        char* end;
+        double value = std::strtod(position, &end);
+        if (end == position)
+        {
+            return false;
+        }
+        values.push_back(value);
+        position = end;
+        if (*position == ',')
+        {
+            ++position;
+        }
+    }
+    return !values.empty();
+}
+
+BatchReader::BatchReader(const std::string& path, size_t batch_rows, size_t skip_columns)
+    : _in(path, std::ios::binary), _path(path), _good(false), _binary(false), _batchRows(std::max<size_t>(1, batch_rows)),
+      _skipColumns(skip_columns), _columns(0), _remaining(0), _line(0)
+{
+    char magic[4];
+    if (_in.read(magic, 4) && std::string(magic, 4) == BINARY_MAGIC)
+    {
+        uint32_t version;
+        uint64_t rows, cols;
+        _binary = true;
+        _good = readValue(_in, version) && version == BINARY_VERSION
+            && readValue(_in, rows) && readValue(_in, cols) && cols >= _skipColumns;
+        _remaining = rows;
+        _columns = _good ? cols - _skipColumns : 0;
+        return;
+    }
+
+    // CSV: si la primera línea no son números es el encabezado
+    _in.clear();
+    _in.seekg(0);
+    std::string line;
+    if (!std::getline(_in, line))
+    {
+        return;
+    }
+    _line = 1;
+    if (!parse_csv_line(line, _pending) && !_readCsvRow(_pending))
+    {
+        return;
+    }
+    _good = _pending.size() >= _skipColumns;
+    _columns = _good ? _pending.size() - _skipColumns : 0;
+}
+
+bool BatchReader::good() const
+{
+    return _good;
+}
+
+size_t BatchReader::columns() const
+{
+    return _columns;
+}
+
+bool BatchReader::_readCsvRow(std::vector<double>& row)
+{
+    std::string line;
+    while (std::getline(_in, line))
+    {
+        ++_line;
+        if (blank(line))
+        {
+            continue;
+        }
+        if (!parse_csv_line(line, row))
+        {
+            _error("tiene un campo que no es un número");
+        }
+        return true;
+    }
+    return false;
+}
+
+void BatchReader::_error(const std::string& message) const
+{
+    throw std::runtime_error(_path + ": la línea " + std::to_string(_line) + " " + message);
+}
+
+Matrix BatchReader::next()
+{
+    if (!_good)
+    {
+        return Matrix(0, _columns);
+    }
+
+    if (_binary)
+    {
+        size_t rows = std::min<uint64_t>(_batchRows, _remaining);
+        Matrix batch(rows, _columns);
+        std::vector<double> row(_columns + _skipColumns);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            if (!_in.read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(double)))
+            {
+                _remaining = 0;
+                return Matrix(batch.topRows(i));
+            }
+            batch.row(i) = Eigen::Map<RowVector>(row.data() + _skipColumns, _columns);
+        }
+        _remaining -= rows;
+        return batch;
+    }
+
+    Matrix batch(_batchRows, _columns);
+    size_t rows = 0;
+    std::vector<double> row;
+    while (rows < _batchRows)
+    {
+        if (!_pending.empty())
+        {
+            row.swap(_pending);
+            _pending.clear();
+        }
+        else if (!_readCsvRow(row))
+        {
+            break;
+        }
+        // Descartar la fila correría todos los índices siguientes (por ejemplo los ImageId de la salida)
+        if (row.size() != _columns + _skipColumns)
+        {
+            _error("tiene " + std::to_string(row.size()) + " columnas y la primera fila "
+                   + std::to_string(_columns + _skipColumns));
+        }
+        batch.row(rows++) = Eigen::Map<RowVector>(row.data() + _skipColumns, _columns);
+    }
+    batch.conservativeResize(rows, _columns);
+    return batch;
+}
+
+bool write_binary(const std::string& path, const MatrixRef& X)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(BINARY_MAGIC, 4);
+    writeValue<uint32_t>(out, BINARY_VERSION);
+    writeValue<uint64_t>(out, X.rows());
+    writeValue<uint64_t>(out, X.cols());
+    for (Eigen::Index i = 0; i < X.rows() && X.cols() > 0; ++i)
+    {
+        out.write(reinterpret_cast<const char*>(X.row(i).data()), X.cols() * sizeof(double));
+    }
+    return (bool)out;
+}
+
+MappedMatrix::MappedMatrix(const std::string& path)
+    : _data(nullptr), _size(0), _rows(0), _cols(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= BINARY_HEADER)
+    {
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            _data = data;
+            _size = info.st_size;
+        }
+    }
+    close(fd);
+    if (_data == nullptr)
+    {
+        return;
+    }
+
+    const char* bytes = static_cast<const char*>(_data);
+    uint32_t version;
+    std::memcpy(&version, bytes + 4, sizeof(uint32_t));
+    std::memcpy(&_rows, bytes + 8, sizeof(uint64_t));
+    std::memcpy(&_cols, bytes + 16, sizeof(uint64_t));
+    if (std::string(bytes, 4) != BINARY_MAGIC || version != BINARY_VERSION
+        || _size - BINARY_HEADER != _rows * _cols * sizeof(double))
+    {
+        munmap(_data, _size);
+        _data = nullptr;
+        _rows = _cols = 0;
+        return;
+    }
+    // Se va a leer de principio a fin
+    madvise(_data, _size, MADV_SEQUENTIAL);
+}
+
+MappedMatrix::~MappedMatrix()
+{
+    if (_data != nullptr)
+    {
+        munmap(_data, _size);
+    }
+}
+
+bool MappedMatrix::good() const
+{
+    return _data != nullptr;
+}
+
+// mmap devuelve el comienzo de una página y el encabezado ocupa 24 bytes, así que los coeficientes
+// están alineados a 8 como cualquier double
+Eigen::Map<const Matrix> MappedMatrix::matrix() const
+{
+    const double* values = _data != nullptr
+        ? reinterpret_cast<const double*>(static_cast<const char*>(_data) + BINARY_HEADER) : nullptr;
+    return Eigen::Map<const Matrix>(values, _rows, _cols);
+}
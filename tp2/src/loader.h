@@ -0,0 +1,80 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "types.h"
+
+/*
+Lectura por lotes de conjuntos de datos que no entran en memoria. Lee CSV (el encabezado se
+detecta solo) o el formato binario de write_binary, y devuelve de a batch_rows filas, así que
+la memoria usada depende del tamaño del lote y no del archivo.
+skip_columns descarta las primeras columnas de cada fila (por ejemplo "label" en train.csv).
+Las líneas vacías del CSV se saltean; una fila con un campo que no es un número o con otra cantidad
+de columnas que la primera tira std::runtime_error con el número de línea.
+*/
+class BatchReader {
+public:
+
+    BatchReader(const std::string& path, size_t batch_rows, size_t skip_columns = 0);
+
+    // Próximo lote; una matriz sin filas indica que no quedan datos
+    Matrix next();
+
+    // false si no se pudo abrir el archivo o el formato no es válido
+    bool good() const;
+
+    size_t columns() const;
+
+private:
+
+    bool _readCsvRow(std::vector<double>& row);
+    [[noreturn]] void _error(const std::string& message) const;
+
+    std::ifstream _in;
+    std::string _path;
+    bool _good;
+    bool _binary;
+    size_t _batchRows;
+    size_t _skipColumns;
+    size_t _columns;
+    // Filas que quedan en el archivo binario
+    uint64_t _remaining;
+    // Primera fila del CSV, leída al detectar el encabezado
+    std::vector<double> _pending;
+    // Última línea leída del CSV, para los mensajes de error
+    size_t _line;
+};
+
+/*
+Formato binario: "TP2B", versión (uint32), filas y columnas (uint64) y los coeficientes en double
+por filas, desde el byte 24. Devuelve false si no se pudo escribir el archivo.
+*/
+bool write_binary(const std::string& path, const MatrixRef& X);
+
+/*
+Archivo del formato binario mapeado en memoria con mmap: matrix() lee directo de las páginas del
+archivo, sin copiarlo, y el sistema operativo carga solo lo que se usa. good() es false si el
+archivo no existe, no tiene el formato binario o está truncado.
+*/
+class MappedMatrix {
+public:
+
+    explicit MappedMatrix(const std::string& path);
+    ~MappedMatrix();
+
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+    bool good() const;
+
+    // Válida mientras viva el objeto
+    Eigen::Map<const Matrix> matrix() const;
+
+private:
+
+    void* _data;
+    size_t _size;
+    uint64_t _rows;
+    uint64_t _cols;
+};
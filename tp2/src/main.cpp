@@ -2,13 +2,290 @@
 // Created by pachi on 5/6/19.
 //
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "pca.h"
 #include "eigen.h"
+#include "knn.h"
+#include "loader.h"
+#include "parallel.h"
+
+/*
+Versión en C++ de tp2.py, sin Python ni pandas.
+
+Uso:
+    tp2 -m <0|1> -i <train> -q <test> -o <salida.csv> [-k 4] [-a 27]
+        -m 0: kNN, -m 1: PCA + kNN con alfa componentes. train tiene la etiqueta en la primera
+        columna y test solo los píxeles, como los CSV de Kaggle. Se escribe el CSV de submission
+        (ImageId,Label) y el tiempo de cada etapa.
+    tp2 convert <entrada.csv> <salida.bin>
+        Pasa un CSV al formato binario de write_binary. Los archivos binarios se leen con mmap,
+        sin parsear texto.
+    tp2 bench-power [dimensión=784] [iteraciones=2000] [semilla=0]
+        Iteraciones por segundo del método de la potencia sobre una matriz de covarianza de esa
+        dimensión (con OMP_NUM_THREADS se elige la cantidad de threads).
+*/
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Lee el archivo entero (CSV o binario) de a lotes. Una fila mal formada se informa y deja ok en false
+static Matrix read_all(const std::string& path, bool& ok)
+{
+    std::vector<Matrix> batches;
+    Eigen::Index rows = 0;
+    size_t columns = 0;
+    try
+    {
+        BatchReader reader(path, 4096);
+        ok = reader.good();
+        columns = reader.columns();
+        for (Matrix batch = reader.next(); ok && batch.rows() > 0; batch = reader.next())
+        {
+            rows += batch.rows();
+            batches.push_back(std::move(batch));
+        }
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << error.what() << std::endl;
+        ok = false;
+        return Matrix();
+    }
+
+    Matrix ret(rows, columns);
+    rows = 0;
+    for (const Matrix& batch : batches)
+    {
+        ret.middleRows(rows, batch.rows()) = batch;
+        rows += batch.rows();
+    }
+    return ret;
+}
+
+/*
+Un conjunto de datos cargado: si el archivo es binario queda mapeado y no se copia,
+si es CSV se parsea a memoria
+*/
+class Dataset {
+public:
+
+    explicit Dataset(const std::string& path) : _mapped(path), _ok(_mapped.good())
+    {
+        if (!_ok)
+        {
+            _data = read_all(path, _ok);
+        }
+    }
+
+    bool good() const
+    {
+        return _ok;
+    }
+
+    MatrixRef matrix() const
+    {
+        return _mapped.good() ? MatrixRef(_mapped.matrix()) : MatrixRef(_data);
+    }
+
+private:
+
+    MappedMatrix _mapped;
+    Matrix _data;
+    bool _ok;
+};
+
+static int usage()
+{
+    std::cerr << "Uso: tp2 -m <0|1> -i <train> -q <test> -o <salida.csv> [-k vecinos] [-a alfa]" << std::endl
+              << "     tp2 convert <entrada.csv> <salida.bin>" << std::endl
+              << "     tp2 bench-power [dimension] [iteraciones] [semilla]" << std::endl;
+    return 1;
+}
+
+static int convert(const std::string& input, const std::string& output)
+{
+    bool ok;
+    Matrix data = read_all(input, ok);
+    if (!ok || !write_binary(output, data))
+    {
+        std::cerr << "No se pudo convertir " << input << " a " << output << std::endl;
+        return 1;
+    }
+    std::cout << data.rows() << " filas, " << data.cols() << " columnas" << std::endl;
+    return 0;
+}
+
+// Con epsilon 0 el método nunca corta antes, así que hace exactamente 'iterations' productos
+static int bench_power(unsigned int dimension, unsigned int iterations, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> normal;
+    Matrix X(2 * dimension, dimension);
+    for (Eigen::Index i = 0; i < X.size(); ++i)
+    {
+        X.data()[i] = normal(generator);
+    }
+    Matrix cov = covariance(X);
+
+    Clock::time_point start = Clock::now();
+    std::pair<double, Vector> e = power_iteration(cov, iterations, 0.0, seed);
+    double elapsed = seconds(start, Clock::now());
+
+    std::cout << "dimension " << dimension << ", threads " << get_num_threads() << std::endl;
+    std::cout << "autovalor " << e.first << std::endl;
+    std::cout << iterations << " iteraciones en " << elapsed << " segundos: "
+              << iterations / elapsed << " iteraciones por segundo" << std::endl;
+    return 0;
+}
 
 int main(int argc, char** argv){
 
-  std::cout << "Hola mundo!" << std::endl;
+    if (argc == 4 && std::strcmp(argv[1], "convert") == 0)
+    {
+        return convert(argv[2], argv[3]);
+    }
+    if (argc >= 2 && argc <= 5 && std::strcmp(argv[1], "bench-power") == 0)
+    {
+        return bench_power(argc > 2 ? std::atoi(argv[2]) : 784, argc > 3 ? std::atoi(argv[3]) : 2000,
+                           argc > 4 ? std::atoi(argv[4]) : 0);
+    }
+
+    int method = -1;
+    unsigned int k = 4;
+    unsigned int alpha = 27;
+    std::string trainPath, testPath, outputPath;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "-m")
+        {
+            method = std::atoi(argv[i + 1]);
+        }
+        else if (option == "-i")
+        {
+            trainPath = argv[i + 1];
+        }
+        else if (option == "-q")
+        {
+            testPath = argv[i + 1];
+        }
+        else if (option == "-o")
+        {
+            outputPath = argv[i + 1];
+        }
+        else if (option == "-k")
+        {
+            k = std::atoi(argv[i + 1]);
+        }
+        else if (option == "-a")
+        {
+            alpha = std::atoi(argv[i + 1]);
+        }
+        else
+        {
+            return usage();
+        }
+    }
+    if ((method != 0 && method != 1) || trainPath.empty() || testPath.empty() || outputPath.empty())
+    {
+        return usage();
+    }
+
+    Clock::time_point start = Clock::now();
+    Dataset train(trainPath);
+    Dataset test(testPath);
+    if (!train.good() || !test.good() || train.matrix().cols() < 2)
+    {
+        std::cerr << "No se pudieron leer " << trainPath << " y " << testPath << std::endl;
+        return 1;
+    }
+    MatrixRef X_train = train.matrix().rightCols(train.matrix().cols() - 1);
+    IntVector y_train = train.matrix().col(0).cast<size_t>();
+    MatrixRef X_test = test.matrix();
+    if (X_test.cols() != X_train.cols())
+    {
+        std::cerr << "El train tiene " << X_train.cols() << " píxeles y el test " << X_test.cols() << std::endl;
+        return 1;
+    }
+    Clock::time_point loaded = Clock::now();
+
+    std::cout << "Nombre del dataset: " << trainPath << std::endl;
+    std::cout << "Nombre del testset: " << testPath << std::endl;
+    std::cout << "Cantidad de documentos: " << X_train.rows() << std::endl;
+    std::cout << "Cantidad de documentos a categorizar: " << X_test.rows() << std::endl;
+
+    KNNClassifier knn(k);
+    IntVector y_predict;
+    double fitTime, transformTime = 0.0, predictTime;
+    if (method == 0)
+    {
+        std::cout << "Metodo utilizado: kNN" << std::endl;
+        std::cout << "k utilizado " << k << std::endl;
+        knn.fit(X_train, y_train);
+        Clock::time_point fitted = Clock::now();
+        y_predict = knn.predict(X_test);
+        fitTime = seconds(loaded, fitted);
+        predictTime = seconds(fitted, Clock::now());
+    }
+    else
+    {
+        std::cout << "Metodo utilizado: PCA + kNN" << std::endl;
+        std::cout << "alfa utilizado " << alpha << std::endl;
+        std::cout << "k utilizado " << k << std::endl;
+        PCA pca(alpha);
+        pca.fit(X_train);
+        Clock::time_point pcaFitted = Clock::now();
+        Matrix X_train_pca = pca.transform(X_train);
+        Matrix X_test_pca = pca.transform(X_test);
+        Clock::time_point transformed = Clock::now();
+        knn.fit(X_train_pca, y_train);
+        Clock::time_point fitted = Clock::now();
+        y_predict = knn.predict(X_test_pca);
+        fitTime = seconds(loaded, pcaFitted) + seconds(transformed, fitted);
+        transformTime = seconds(pcaFitted, transformed);
+        predictTime = seconds(fitted, Clock::now());
+    }
+
+    Clock::time_point predicted = Clock::now();
+    std::ofstream output(outputPath);
+    output << "ImageId,Label" << std::endl;
+    for (Eigen::Index i = 0; i < y_predict.rows(); ++i)
+    {
+        output << i + 1 << "," << y_predict(i) << "\n";
+    }
+    if (!output)
+    {
+        std::cerr << "No se pudo escribir " << outputPath << std::endl;
+        return 1;
+    }
+    output.close();
+    Clock::time_point written = Clock::now();
+
+    // distancias, selección y votación son la suma de los threads y juntas pueden superar a predict
+    const KNNTimings& timings = knn.timings();
+    std::cout << "Tiempos (segundos):" << std::endl;
+    std::cout << "  carga       " << seconds(start, loaded) << std::endl;
+    std::cout << "  fit         " << fitTime << std::endl;
+    std::cout << "  transform   " << transformTime << std::endl;
+    std::cout << "  predict     " << predictTime << std::endl;
+    std::cout << "    distancias " << timings.distances << std::endl;
+    std::cout << "    seleccion  " << timings.selection << std::endl;
+    std::cout << "    votacion   " << timings.vote << std::endl;
+    std::cout << "  escritura   " << seconds(predicted, written) << std::endl;
+    std::cout << "  total       " << seconds(start, written) << std::endl;
 
-  return 0;
+    return 0;
 }
@@ -1,30 +1,96 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include "knn.h"
 #include "pca.h"
+#include "pipeline.h"
 #include "eigen.h"
+#include "parallel.h"
+#include "loader.h"
+#include "crossval.h"
 
 namespace py=pybind11;
 
 // el primer argumento es el nombre...
 PYBIND11_MODULE(metnum, m) {
+    py::class_<KNNTimings>(m, "KNNTimings")
+        .def_readonly("distances", &KNNTimings::distances)
+        .def_readonly("selection", &KNNTimings::selection)
+        .def_readonly("vote", &KNNTimings::vote);
+
     py::class_<KNNClassifier>(m, "KNNClassifier")
-        .def(py::init<unsigned int>())
-        .def("fit", &KNNClassifier::fit)
-        .def("predict", &KNNClassifier::predict)
-        .def("predictWithK", &KNNClassifier::predictWithK);
+        .def(py::init<unsigned int, unsigned int, const std::string&, unsigned int, unsigned int,
+                      const std::string&, unsigned int, const std::string&>(),
+             py::arg("n_neighbors"), py::arg("k_max")=0, py::arg("algorithm")="auto",
+             py::arg("nlist")=0, py::arg("nprobe")=8,
+             py::arg("storage")="double", py::arg("pq_subspaces")=0, py::arg("weights")="uniform")
+        .def("fit", &KNNClassifier::fit, py::call_guard<py::gil_scoped_release>())
+        // X tiene que ser float64 con filas contiguas (si no, pybind11 rechaza la llamada en lugar
+        // de convertir) y queda vivo mientras viva el clasificador
+        .def("fitNoCopy", &KNNClassifier::fitNoCopy, py::arg("X").noconvert(), py::arg("y"),
+             py::keep_alive<1, 2>(), py::call_guard<py::gil_scoped_release>())
+        // X es una scipy.sparse.csr_matrix (pybind11 convierte las csc y demás formatos a csr)
+        .def("fitSparse", &KNNClassifier::fitSparse, py::arg("X"), py::arg("y"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("predict", &KNNClassifier::predict, py::call_guard<py::gil_scoped_release>())
+        .def("predictSparse", &KNNClassifier::predictSparse, py::arg("X"), py::call_guard<py::gil_scoped_release>())
+        .def("predictWithK", &KNNClassifier::predictWithK, py::call_guard<py::gil_scoped_release>())
+        .def("predictWithKs", &KNNClassifier::predictWithKs, py::call_guard<py::gil_scoped_release>())
+        .def("cacheMemory", &KNNClassifier::cacheMemory)
+        .def("trainMemory", &KNNClassifier::trainMemory)
+        .def("algorithm", &KNNClassifier::algorithm)
+        .def("timings", &KNNClassifier::timings)
+        .def("setNProbe", &KNNClassifier::setNProbe, py::arg("nprobe"))
+        .def("neighbors", &KNNClassifier::neighbors)
+        .def("save", &KNNClassifier::save, py::arg("path"))
+        .def("load", &KNNClassifier::load, py::arg("path"), py::call_guard<py::gil_scoped_release>());
 
     py::class_<PCA>(m, "PCA")
-        .def(py::init<unsigned int>())
-        .def("fit", &PCA::fit)
-        .def("transform", &PCA::transform)
-        .def("transformBeta", &PCA::transformBeta);
+        .def(py::init<unsigned int, const std::string&, unsigned int, unsigned int, bool>(),
+             py::arg("n_components"), py::arg("solver")="subspace",
+             py::arg("oversampling")=10, py::arg("power_iterations")=2, py::arg("warm_start")=false)
+        .def("fit", &PCA::fit, py::call_guard<py::gil_scoped_release>())
+        .def("fitSparse", &PCA::fitSparse, py::arg("X"), py::call_guard<py::gil_scoped_release>())
+        .def("partial_fit", &PCA::partial_fit, py::call_guard<py::gil_scoped_release>())
+        .def("transform", &PCA::transform, py::call_guard<py::gil_scoped_release>())
+        .def("transformBeta", &PCA::transformBeta, py::call_guard<py::gil_scoped_release>())
+        .def("transformSparse", &PCA::transformSparse, py::arg("X"), py::call_guard<py::gil_scoped_release>())
+        .def("components", &PCA::components)
+        .def("mean", &PCA::mean)
+        .def("products", &PCA::products)
+        .def("save", &PCA::save, py::arg("path"))
+        .def("load", &PCA::load, py::arg("path"));
+
+    py::class_<PCAKNNPipeline>(m, "PCAKNNPipeline")
+        .def(py::init<unsigned int, unsigned int, unsigned int, const std::string&, const std::string&>(),
+             py::arg("n_components"), py::arg("n_neighbors"), py::arg("k_max")=0,
+             py::arg("algorithm")="auto", py::arg("solver")="subspace")
+        .def("fit", &PCAKNNPipeline::fit, py::call_guard<py::gil_scoped_release>())
+        .def("predict", &PCAKNNPipeline::predict, py::call_guard<py::gil_scoped_release>())
+        .def("predictWithK", &PCAKNNPipeline::predictWithK, py::call_guard<py::gil_scoped_release>())
+        .def("pca", &PCAKNNPipeline::pca, py::return_value_policy::reference_internal);
+
+    py::class_<BatchReader>(m, "BatchReader")
+        .def(py::init<const std::string&, size_t, size_t>(),
+             py::arg("path"), py::arg("batch_rows"), py::arg("skip_columns")=0)
+        .def("next", &BatchReader::next, py::call_guard<py::gil_scoped_release>())
+        .def("good", &BatchReader::good)
+        .def("columns", &BatchReader::columns);
+    m.def(
+        "write_binary", &write_binary,
+        "Writes a matrix in the binary format read by BatchReader",
+        py::arg("path"),
+        py::arg("X")
+    );
+
     m.def(
         "power_iteration", &power_iteration,
         "Function that calculates eigenvector",
         py::arg("X"),
         py::arg("num_iter")=5000,
-        py::arg("epsilon")=1e-16
+        py::arg("epsilon")=1e-16,
+        py::arg("seed")=0,
+        py::call_guard<py::gil_scoped_release>()
     );
     m.def(
         "get_first_eigenvalues", &get_first_eigenvalues,
@@ -32,7 +98,80 @@ PYBIND11_MODULE(metnum, m) {
         py::arg("X"),
         py::arg("num"),
         py::arg("num_iter")=5000,
-        py::arg("epsilon")=1e-16
+        py::arg("epsilon")=1e-16,
+        py::arg("initial")=Matrix(),
+        py::arg("seed")=0,
+        py::call_guard<py::gil_scoped_release>()
+    );
+    m.def(
+        "subspace_iteration", &subspace_iteration,
+        "Function that calculates the leading eigenvectors of a symmetric matrix all at once",
+        py::arg("X"),
+        py::arg("num"),
+        py::arg("num_iter")=1000,
+        py::arg("epsilon")=1e-10,
+        py::arg("initial")=Matrix(),
+        py::call_guard<py::gil_scoped_release>()
+    );
+    m.def(
+        "lanczos", &lanczos,
+        "Function that calculates the leading eigenvectors of a symmetric matrix with thick-restart Lanczos",
+        py::arg("X"),
+        py::arg("num"),
+        py::arg("num_iter")=1000,
+        py::arg("epsilon")=1e-10,
+        py::arg("initial")=Matrix(),
+        py::call_guard<py::gil_scoped_release>()
+    );
+
+    py::class_<EigenResult>(m, "EigenResult")
+        .def_readonly("eigenvalues", &EigenResult::eigenvalues)
+        .def_readonly("eigenvectors", &EigenResult::eigenvectors)
+        .def_readonly("products", &EigenResult::products)
+        .def_readonly("residuals", &EigenResult::residuals)
+        .def_readonly("seconds", &EigenResult::seconds);
+    m.def(
+        "eigen_solve", &eigen_solve,
+        "Runs the given eigen solver (power, subspace or lanczos) and reports products, residuals and time",
+        py::arg("X"),
+        py::arg("num"),
+        py::arg("method")="subspace",
+        py::arg("num_iter")=1000,
+        py::arg("epsilon")=1e-10,
+        py::arg("initial")=Matrix(),
+        py::call_guard<py::gil_scoped_release>()
+    );
+    m.def(
+        "cross_validate",
+        [](const MatrixRef& X, const IntVector& y, unsigned int folds, const IntVector& betas, const IntVector& ks,
+           bool shuffle, unsigned int seed, const std::string& solver) {
+            Matrix accuracy;
+            {
+                py::gil_scoped_release release;
+                accuracy = cross_validate(X, y, folds, betas, ks, shuffle, seed, solver);
+            }
+            // accuracy[fold, beta, k]
+            Eigen::Index rows = betas.size() > 0 ? accuracy.rows() / betas.size() : 0;
+            return py::array_t<double>({rows, betas.size(), ks.size()}, accuracy.data());
+        },
+        "K-fold cross-validation of PCA + KNN over grids of betas and ks; returns accuracy[fold, beta, k]",
+        py::arg("X"),
+        py::arg("y"),
+        py::arg("folds"),
+        py::arg("betas"),
+        py::arg("ks"),
+        py::arg("shuffle")=true,
+        py::arg("seed")=0,
+        py::arg("solver")="subspace"
+    );
+    m.def(
+        "set_num_threads", &set_num_threads,
+        "Sets the number of threads used by the parallel code",
+        py::arg("threads")
+    );
+    m.def(
+        "get_num_threads", &get_num_threads,
+        "Returns the number of threads used by the parallel code"
     );
 
 }
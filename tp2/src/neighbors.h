@@ -0,0 +1,52 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+#include "types.h"
+
+/*
+Los k candidatos más cercanos vistos hasta el momento, en un max-heap por distancia (al cuadrado).
+A igual distancia gana el índice menor, igual que en la búsqueda por fuerza bruta.
+*/
+class NeighborHeap {
+public:
+
+    explicit NeighborHeap(size_t k) : _k(k) {}
+
+    bool full() const { return _k > 0 && _heap.size() == _k; }
+
+    // Distancia del k-ésimo candidato; solo tiene sentido si full()
+    double worst() const { return _heap.top().first; }
+
+    void push(double distance, uint32_t index)
+    {
+        Candidate candidate(distance, index);
+        if (_heap.size() < _k)
+        {
+            _heap.push(candidate);
+        }
+        else if (_k > 0 && candidate < _heap.top())
+        {
+            _heap.pop();
+            _heap.push(candidate);
+        }
+    }
+
+    // Escribe los candidatos ordenados por distancia y vacía el heap
+    void write(uint32_t* indices, float* distances)
+    {
+        for (size_t i = _heap.size(); i > 0; --i)
+        {
+            indices[i - 1] = _heap.top().second;
+            distances[i - 1] = _heap.top().first;
+            _heap.pop();
+        }
+    }
+
+private:
+
+    typedef std::pair<double, uint32_t> Candidate;
+
+    size_t _k;
+    std::priority_queue<Candidate> _heap;
+};
@@ -0,0 +1,23 @@
+#include "parallel.h"
+#include "types.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+void set_num_threads(int threads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    Eigen::setNbThreads(threads);
+}
+
+int get_num_threads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
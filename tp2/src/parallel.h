@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+Cantidad de threads que usan las partes paralelas (OpenMP y los productos de Eigen).
+Sin OpenMP todo corre en un único thread y set_num_threads no tiene efecto.
+*/
+void set_num_threads(int threads);
+
+int get_num_threads();
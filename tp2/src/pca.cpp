@@ -1,27 +1,285 @@
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <Eigen/SVD>
 #include "pca.h"
 #include "eigen.h"
+#include "serialize.h"
 
 using namespace std;
 
-PCA::PCA(unsigned int n_components) : _alpha(n_components)
+// Columnas de cada panel de la covarianza que calcula un thread
+static const Eigen::Index COVARIANCE_PANEL = 64;
+
+// Versión del formato de save/load
+static const uint32_t MODEL_VERSION = 1;
+
+/**
+* Calcula (X^T X - n mu mu^T) / (n - 1), que es igual a la covarianza de los datos centrados.
+* Solo se calcula el triángulo inferior: cada panel de columnas [j, j + COVARIANCE_PANEL) es un
+* producto X[:, j:]^T X[:, j:j+p] que se escribe directo en su bloque de la matriz resultado,
+* así que los threads no comparten nada y no hace falta otra matriz de d x d.
+*/
+Matrix covariance(const MatrixRef& X)
+{
+    Eigen::Index n = X.rows();
+    Eigen::Index d = X.cols();
+    RowVector mean = X.colwise().mean();
+    Matrix cov(d, d);
+
+    Eigen::Index panels = (d + COVARIANCE_PANEL - 1) / COVARIANCE_PANEL;
+    #pragma omp parallel for schedule(dynamic)
+    for (Eigen::Index panel = 0; panel < panels; ++panel)
+    {
+        Eigen::Index first = panel * COVARIANCE_PANEL;
+        Eigen::Index width = std::min(COVARIANCE_PANEL, d - first);
+        auto block = cov.block(first, first, d - first, width);
+        block.noalias() = X.rightCols(d - first).transpose() * X.middleCols(first, width);
+        block.noalias() -= double(n) * mean.tail(d - first).transpose() * mean.segment(first, width);
+        block /= double(n - 1);
+    }
+
+    cov.triangularView<Eigen::StrictlyUpper>() = cov.transpose();
+    return cov;
+}
+
+// Media de las columnas de X rala: 1^T X / n es un producto denso por ralo
+static RowVector column_means(const SparseMatrix& X)
+{
+    return RowVector::Ones(X.rows()) * X / double(X.rows());
+}
+
+/**
+* Igual que para X densa: X^T X es un producto ralo por ralo que Eigen escribe directo en la
+* matriz densa de d x d, así que X nunca se arma densa ni centrada.
+*/
+Matrix covariance(const SparseMatrix& X)
+{
+    Eigen::Index n = X.rows();
+    RowVector mean = column_means(X);
+    Matrix cov = X.transpose() * X;
+    cov.noalias() -= double(n) * mean.transpose() * mean;
+    cov /= double(n - 1);
+    return cov;
+}
+
+static bool valid_solver(const std::string& solver)
+{
+    return solver == "subspace" || solver == "lanczos" || solver == "power" || solver == "randomized";
+}
+
+PCA::PCA(unsigned int n_components, const std::string& solver, unsigned int oversampling, unsigned int power_iterations,
+         bool warm_start)
+    : _alpha(n_components), _solver(solver), _oversampling(oversampling), _powerIterations(power_iterations),
+      _warmStart(warm_start), _products(0), _samples(0)
+{
+    if (!valid_solver(_solver))
+    {
+        throw std::invalid_argument("PCA: solver tiene que ser \"subspace\", \"lanczos\", \"power\" o \"randomized\"");
+    }
+}
+
+void PCA::fit(const MatrixRef& X)
+{
+    if (_solver == "randomized")
+    {
+        _fitRandomized(X, X.colwise().mean());
+        return;
+    }
+    _fitCovariance(covariance(X), X.rows(), X.colwise().mean());
+}
+
+void PCA::fitSparse(const SparseMatrix& X)
+{
+    if (_solver == "randomized")
+    {
+        _fitRandomized(X, column_means(X));
+        return;
+    }
+    _fitCovariance(covariance(X), X.rows(), column_means(X));
+}
+
+void PCA::_fitCovariance(const Matrix& cov, Eigen::Index rows, const RowVector& mean)
+{
+    Matrix initial;
+    if (_warmStart && _base.rows() == cov.rows())
+    {
+        initial = _base;
+    }
+    // El método de la potencia tiene un paso por iteración, así que necesita más que los otros
+    EigenResult eigen = eigen_solve(cov, _alpha, _solver, _solver == "power" ? 5000 : 1000, 1e-10, initial);
+    _base = eigen.eigenvectors;
+    _products = eigen.products;
+
+    _samples = rows;
+    _mean = mean;
+    _singularValues = (eigen.eigenvalues.cwiseMax(0.0) * double(rows - 1)).cwiseSqrt();
+}
+
+/**
+* Se arma una matriz chica con la misma dispersión que todo lo visto hasta ahora más el lote:
+* las componentes actuales escaladas por sus valores singulares, el lote centrado en su media y
+* una fila que corrige la diferencia entre la media anterior y la del lote. Sus primeros vectores
+* singulares derechos son las nuevas componentes.
+*/
+void PCA::partial_fit(const MatrixRef& batch)
+{
+    Eigen::Index rows = batch.rows();
+    if (rows == 0)
+    {
+        return;
+    }
+    RowVector batchMean = batch.colwise().mean();
+    Eigen::Index current = _samples > 0 ? _singularValues.size() : 0;
+
+    Eigen::MatrixXd stacked(current + rows + (_samples > 0 ? 1 : 0), batch.cols());
+    if (_samples > 0)
+    {
+        stacked.topRows(current) = _singularValues.asDiagonal() * _base.transpose();
+        stacked.bottomRows(1) = std::sqrt(double(_samples) * rows / double(_samples + rows)) * (_mean - batchMean);
+    }
+    stacked.middleRows(current, rows) = batch.rowwise() - batchMean;
+
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(stacked, Eigen::ComputeThinV);
+    Eigen::Index components = std::min<Eigen::Index>(_alpha, svd.singularValues().size());
+    _base = svd.matrixV().leftCols(components);
+    _singularValues = svd.singularValues().head(components);
+
+    _mean = _samples > 0 ? RowVector((double(_samples) * _mean + double(rows) * batchMean) / double(_samples + rows))
+                         : batchMean;
+    _samples += rows;
+}
+
+/**
+* SVD aleatorizada (Halko, Martinsson y Tropp): se busca una base Q del rango de los datos centrados
+* Xc = X - 1 mu^T multiplicándolos por una matriz gaussiana de alpha + oversampling columnas,
+* se refina con iteraciones de potencia sobre Xc Xc^T y las componentes salen de la SVD de la
+* matriz chica Q^T Xc. Xc nunca se arma: cada producto se corrige con la media. Solo se usan
+* productos de X por matrices densas, así que X puede ser densa o rala.
+*/
+template<typename Data>
+void PCA::_fitRandomized(const Data& X, const RowVector& mean)
+{
+    Eigen::Index n = X.rows();
+    Eigen::Index d = X.cols();
+    Eigen::Index rank = std::min<Eigen::Index>(_alpha + _oversampling, std::min(n, d));
+    RowVector ones = RowVector::Ones(n);
+
+    std::mt19937 generator(0);
+    std::normal_distribution<double> normal;
+    Matrix omega(d, rank);
+    for (Eigen::Index i = 0; i < omega.size(); ++i)
+    {
+        omega.data()[i] = normal(generator);
+    }
+
+    // Q: base ortonormal de Xc * omega
+    auto orthonormalize = [](const Matrix& Y) {
+        return Matrix(Eigen::HouseholderQR<Matrix>(Y).householderQ() * Matrix::Identity(Y.rows(), Y.cols()));
+    };
+    Matrix Q = orthonormalize(X * omega - Vector::Ones(n) * (mean * omega));
+    for (size_t i = 0; i < _powerIterations; ++i)
+    {
+        // Xc^T Q = X^T Q - mu^T (1^T Q)
+        Matrix Z = orthonormalize(X.transpose() * Q - mean.transpose() * (ones * Q));
+        Q = orthonormalize(X * Z - Vector::Ones(n) * (mean * Z));
+    }
+
+    // B = Q^T Xc = Q^T X - (Q^T 1) mu
+    Eigen::MatrixXd B = Q.transpose() * X - (Q.transpose() * Vector::Ones(n)) * mean;
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(B, Eigen::ComputeThinV);
+    Eigen::Index components = std::min<Eigen::Index>(_alpha, rank);
+    _base = svd.matrixV().leftCols(components);
+
+    _samples = n;
+    _mean = mean;
+    _singularValues = svd.singularValues().head(components);
+    _products = 0;
+}
+
+const Matrix& PCA::components() const
 {
-    
+    return _base;
 }
 
-void PCA::fit(const Matrix& X)
+const RowVector& PCA::mean() const
 {
-    Matrix center = X.rowwise() - X.colwise().mean();
-    Matrix cov = (center.transpose() * center) / double(X.rows() - 1);
-    _base = get_first_eigenvalues(cov, _alpha).second;
+    return _mean;
 }
 
-Matrix PCA::transform(const Matrix& X)
+unsigned int PCA::products() const
+{
+    return _products;
+}
+
+/**
+* Formato: "PCA1", versión, parámetros, filas vistas, media, componentes y valores singulares.
+*/
+bool PCA::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write("PCA1", 4);
+    writeValue<uint32_t>(out, MODEL_VERSION);
+    writeValue<uint64_t>(out, _alpha);
+    writeString(out, _solver);
+    writeValue<uint64_t>(out, _oversampling);
+    writeValue<uint64_t>(out, _powerIterations);
+    writeValue<uint8_t>(out, _warmStart);
+    writeValue<uint64_t>(out, _samples);
+    writeMatrix(out, _mean);
+    writeMatrix(out, _base);
+    writeMatrix(out, _singularValues);
+    return (bool)out;
+}
+
+bool PCA::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t version;
+    uint64_t alpha, oversampling, powerIterations, samples;
+    uint8_t warmStart;
+    std::string solver;
+    if (!in.read(magic, 4) || std::string(magic, 4) != "PCA1"
+        || !readValue(in, version) || version != MODEL_VERSION
+        || !readValue(in, alpha) || !readString(in, solver)
+        || !readValue(in, oversampling) || !readValue(in, powerIterations)
+        || !readValue(in, warmStart) || !readValue(in, samples) || !valid_solver(solver))
+    {
+        return false;
+    }
+
+    // Se lee todo en un modelo nuevo para no dejar este a medio cargar si el archivo está mal
+    PCA model(alpha, solver, oversampling, powerIterations, warmStart);
+    model._samples = samples;
+    if (!readMatrix(in, model._mean) || !readMatrix(in, model._base) || !readMatrix(in, model._singularValues)
+        || model._base.rows() != model._mean.cols() || model._base.cols() != model._singularValues.rows())
+    {
+        return false;
+    }
+
+    *this = model;
+    return true;
+}
+
+Matrix PCA::transform(const MatrixRef& X)
 {
     return transformBeta(X, _alpha);
 }
 
-Matrix PCA::transformBeta(const Matrix& X, unsigned int beta)
+Matrix PCA::transformBeta(const MatrixRef& X, unsigned int beta)
+{
+    Eigen::Index components = std::min<Eigen::Index>(beta, _base.cols());
+    // (X - 1 mu^T) B = X B - 1 (mu^T B): se centra en el espacio chico, sin copiar X
+    Matrix projected = X * _base.leftCols(components);
+    projected.rowwise() -= _mean * _base.leftCols(components);
+    return projected;
+}
+
+Matrix PCA::transformSparse(const SparseMatrix& X)
 {
-    return X * _base.block(0, 0, X.rows(), beta);
+    Matrix projected = X * _base;
+    projected.rowwise() -= _mean * _base;
+    return projected;
 }
@@ -1,19 +1,77 @@
 #pragma once
+#include <string>
 #include "types.h"
 
+// Matriz de covarianza de las filas de X, sin armar la copia centrada de X
+Matrix covariance(const MatrixRef& X);
+Matrix covariance(const SparseMatrix& X);
+
 class PCA {
 public:
-    PCA(unsigned int n_components);
+    // solver: "subspace" (iteración en subespacios, todas las componentes juntas),
+    //         "lanczos" o "power" (método de la potencia con deflación, una componente por vez)
+    //         calculan la matriz de covarianza; "randomized" (SVD aleatorizada) trabaja directo
+    //         sobre los datos centrados y sirve cuando la covarianza no entra en memoria. Otro nombre tira
+    //         std::invalid_argument.
+    // oversampling y power_iterations solo se usan con "randomized": más de cualquiera de los dos
+    // da componentes más precisas a cambio de más tiempo
+    // warm_start: fit arranca el solver desde las componentes del ajuste anterior (o de load) en lugar
+    //             de vectores al azar; si los datos cambiaron poco converge en muchas menos iteraciones.
+    //             No tiene efecto con "randomized"
+    PCA(unsigned int n_components, const std::string& solver = "subspace",
+        unsigned int oversampling = 10, unsigned int power_iterations = 2, bool warm_start = false);
+
+    void fit(const MatrixRef& X);
+
+    // fit para datos ralos (por ejemplo scipy.sparse.csr_matrix): la covarianza sale de X^T X ralo
+    // y "randomized" solo multiplica X por matrices densas, así que X nunca se arma densa
+    void fitSparse(const SparseMatrix& X);
 
-    void fit(const Matrix& X);
+    // Actualiza media y componentes con un lote de filas (PCA incremental de Ross et al.), así que
+    // se puede ajustar sobre datos que no entran en memoria de a un lote por vez. Si antes se llamó
+    // a fit, continúa desde ese ajuste. No usa el solver: cada lote es una SVD de
+    // (n_components + filas del lote + 1) filas
+    void partial_fit(const MatrixRef& batch);
 
-    Matrix transform(const Matrix& X);
+    // Centra X con la media del entrenamiento y la proyecta sobre las componentes
+    Matrix transform(const MatrixRef& X);
 
     //Agrego este método adicional para no volver a calcular toda la matriz de autovectores por cada alpha
     //En lugar utilizo PCA con alpha=X.cols y transformo los datos con beta <= alpha componentes
-    Matrix transformBeta(const Matrix& X, unsigned int beta);
+    Matrix transformBeta(const MatrixRef& X, unsigned int beta);
+
+    Matrix transformSparse(const SparseMatrix& X);
+
+    // Componentes principales, una por columna
+    const Matrix& components() const;
+
+    // Media de las filas con las que se ajustó
+    const RowVector& mean() const;
+
+    // Productos matriz-vector que hizo el solver en el último fit (0 con "randomized")
+    unsigned int products() const;
+
+    // Guardan parámetros, media y componentes para no volver a ajustar, o para seguir con
+    // partial_fit o un fit con warm_start. Devuelven false si no se pudo escribir o leer el archivo
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
 
 private:
+    void _fitCovariance(const Matrix& cov, Eigen::Index rows, const RowVector& mean);
+    template<typename Data>
+    void _fitRandomized(const Data& X, const RowVector& mean);
+
     size_t _alpha;
+    std::string _solver;
+    size_t _oversampling;
+    size_t _powerIterations;
+    bool _warmStart;
     Matrix _base;
+    unsigned int _products;
+
+    // Lo que necesita partial_fit para seguir: filas vistas, su media y los valores singulares
+    // de los datos centrados en la dirección de cada componente
+    size_t _samples;
+    RowVector _mean;
+    Vector _singularValues;
 };
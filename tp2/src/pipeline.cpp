@@ -0,0 +1,44 @@
+#include "pipeline.h"
+
+using namespace std;
+
+PCAKNNPipeline::PCAKNNPipeline(unsigned int n_components, unsigned int n_neighbors, unsigned int k_max,
+                               const std::string& algorithm, const std::string& solver)
+    : _pca(n_components, solver), _knn(n_neighbors, k_max, algorithm)
+{
+}
+
+void PCAKNNPipeline::fit(const MatrixRef& X, const IntVector& y)
+{
+    _pca.fit(X);
+    _meanProjection = _pca.mean() * _pca.components();
+    _project(X);
+    _knn.fit(_projected, y);
+
+    // El KNN se quedó con su copia; el buffer solo tiene que ser del tamaño de las consultas
+    _projected.resize(0, _projected.cols());
+}
+
+IntVector PCAKNNPipeline::predict(const MatrixRef& X)
+{
+    _project(X);
+    return _knn.predict(_projected);
+}
+
+IntVector PCAKNNPipeline::predictWithK(size_t k_neighbors)
+{
+    return _knn.predictWithK(k_neighbors);
+}
+
+const PCA& PCAKNNPipeline::pca() const
+{
+    return _pca;
+}
+
+void PCAKNNPipeline::_project(const MatrixRef& X)
+{
+    // resize no vuelve a pedir memoria si el tamaño no cambia
+    _projected.resize(X.rows(), _pca.components().cols());
+    _projected.noalias() = X * _pca.components();
+    _projected.rowwise() -= _meanProjection;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include "types.h"
+#include "pca.h"
+#include "knn.h"
+
+/*
+PCA seguido de KNN en un solo objeto.
+
+fit ajusta PCA y entrena el KNN con los datos ya proyectados. En predict las consultas se
+proyectan con un solo producto X B (la media se resta después, en el espacio de n_components
+columnas) sobre un buffer que se reutiliza entre llamadas, y ese buffer va directo a las
+distancias del KNN: no se arma la copia centrada de X ni se pasa la proyección por Python.
+*/
+class PCAKNNPipeline {
+public:
+
+    // Los parámetros son los de PCA (n_components, solver) y KNNClassifier (n_neighbors, k_max, algorithm)
+    PCAKNNPipeline(unsigned int n_components, unsigned int n_neighbors, unsigned int k_max = 0,
+                   const std::string& algorithm = "auto", const std::string& solver = "subspace");
+
+    void fit(const MatrixRef& X, const IntVector& y);
+
+    IntVector predict(const MatrixRef& X);
+
+    // Igual que KNNClassifier::predictWithK, con los vecinos del último predict
+    IntVector predictWithK(size_t k_neighbors);
+
+    const PCA& pca() const;
+
+private:
+
+    void _project(const MatrixRef& X);
+
+    PCA _pca;
+    KNNClassifier _knn;
+
+    // mu^T B, lo que hay que restarle a cada fila de X B para centrarla
+    RowVector _meanProjection;
+    Matrix _projected;
+};
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "quantization.h"
+#include "kmeans.h"
+#include "serialize.h"
+
+using namespace std;
+
+// Filas que se usan como máximo para entrenar los centroides de cada subespacio
+static const Eigen::Index PQ_TRAIN_ROWS = 8192;
+
+// Filas de codes que ScalarQuantizer::distances compara con todas las consultas antes de pasar a las siguientes
+static const Eigen::Index SQ_CODE_BLOCK = 64;
+
+ScalarQuantizer::ScalarQuantizer() : _offset(0.0), _scale(1.0)
+{
+}
+
+void ScalarQuantizer::fit(const MatrixRef& X)
+{
+    _offset = X.size() > 0 ? X.minCoeff() : 0.0;
+    double range = X.size() > 0 ? X.maxCoeff() - _offset : 0.0;
+    // Si todos los valores son enteros y el rango entra en [0, 255] no se escala, para que los
+    // píxeles se guarden sin pérdida. Si no, el rango se reparte en los 256 códigos: con escala 1
+    // unos datos en [0, 1] quedarían redondeados a 0 o 1
+    bool integers = (X.array() == X.array().round()).all();
+    if (range == 0.0 || (integers && range <= 255.0))
+    {
+        _scale = 1.0;
+    }
+    else
+    {
+        _scale = range / 255.0;
+    }
+}
+
+ByteMatrix ScalarQuantizer::encode(const MatrixRef& X) const
+{
+    return ((X.array() - _offset) / _scale).round().max(0.0).min(255.0).cast<uint8_t>();
+}
+
+/**
+* Suma de cuadrados de las diferencias de dos filas de bytes. Con SSE2 se procesan 16 bytes por
+* paso: se extienden a 16 bits, se restan y _mm_madd_epi16 eleva al cuadrado y suma de a pares en
+* 32 bits (cada par suma a lo sumo 2 * 255², así que no desborda). El resto va escalar.
+*/
+static inline uint32_t squared_distance(const uint8_t* a, const uint8_t* b, Eigen::Index n)
+{
+    Eigen::Index i = 0;
+    uint32_t sum = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i low = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+        __m128i high = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(low, low));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(high, high));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; ++i)
+    {
+        int32_t d = (int32_t)a[i] - (int32_t)b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+Matrix ScalarQuantizer::distances(const ByteMatrix& queries, const ByteMatrix& codes) const
+{
+    Matrix ret(queries.rows(), codes.rows());
+    double scale2 = _scale * _scale;
+    // Un bloque de filas de codes se compara con todas las consultas mientras está en cache, y cada
+    // consulta escribe un tramo contiguo de su fila de ret
+    for (Eigen::Index first = 0; first < codes.rows(); first += SQ_CODE_BLOCK)
+    {
+        Eigen::Index last = std::min(first + SQ_CODE_BLOCK, codes.rows());
+        for (Eigen::Index i = 0; i < queries.rows(); ++i)
+        {
+            for (Eigen::Index j = first; j < last; ++j)
+            {
+                ret(i, j) = scale2 * squared_distance(&queries(i, 0), &codes(j, 0), codes.cols());
+            }
+        }
+    }
+    return ret;
+}
+
+void ScalarQuantizer::save(std::ostream& out) const
+{
+    writeValue(out, _offset);
+    writeValue(out, _scale);
+}
+
+bool ScalarQuantizer::load(std::istream& in)
+{
+    return readValue(in, _offset) && readValue(in, _scale);
+}
+
+ProductQuantizer::ProductQuantizer()
+{
+}
+
+size_t ProductQuantizer::subspaces() const
+{
+    return _codebooks.size();
+}
+
+void ProductQuantizer::fit(const MatrixRef& X, size_t subspaces, size_t iterations, unsigned int seed)
+{
+    subspaces = std::max<size_t>(1, std::min<size_t>(subspaces, X.cols()));
+    _bounds.resize(subspaces + 1);
+    for (size_t s = 0; s <= subspaces; ++s)
+    {
+        _bounds[s] = X.cols() * s / subspaces;
+    }
+
+    // Los centroides se entrenan con una muestra de las filas
+    std::vector<uint32_t> sample(X.rows());
+    std::iota(sample.begin(), sample.end(), 0);
+    std::mt19937 generator(seed);
+    std::shuffle(sample.begin(), sample.end(), generator);
+    sample.resize(std::min(PQ_TRAIN_ROWS, X.rows()));
+
+    _codebooks.resize(subspaces);
+    std::vector<uint32_t> assignment;
+    for (size_t s = 0; s < subspaces; ++s)
+    {
+        Matrix sub(sample.size(), _bounds[s + 1] - _bounds[s]);
+        for (size_t i = 0; i < sample.size(); ++i)
+        {
+            sub.row(i) = X.row(sample[i]).segment(_bounds[s], sub.cols());
+        }
+        _codebooks[s] = kmeans(sub, 256, iterations, seed + s, assignment);
+    }
+}
+
+ByteMatrix ProductQuantizer::encode(const MatrixRef& X) const
+{
+    ByteMatrix codes(X.rows(), _codebooks.size());
+    std::vector<uint32_t> assignment;
+    for (size_t s = 0; s < _codebooks.size(); ++s)
+    {
+        assign_to_centroids(X.middleCols(_bounds[s], _bounds[s + 1] - _bounds[s]), _codebooks[s], assignment);
+        for (Eigen::Index i = 0; i < X.rows(); ++i)
+        {
+            codes(i, s) = assignment[i];
+        }
+    }
+    return codes;
+}
+
+Matrix ProductQuantizer::distances(const MatrixRef& queries, const ByteMatrix& codes) const
+{
+    Matrix ret(queries.rows(), codes.rows());
+    // table(s, c): distancia de la consulta al centroide c del subespacio s
+    Matrix table = Matrix::Zero(_codebooks.size(), 256);
+    for (Eigen::Index i = 0; i < queries.rows(); ++i)
+    {
+        for (size_t s = 0; s < _codebooks.size(); ++s)
+        {
+            RowVector sub = queries.row(i).segment(_bounds[s], _bounds[s + 1] - _bounds[s]);
+            table.row(s).head(_codebooks[s].rows()) = (_codebooks[s].rowwise() - sub).rowwise().squaredNorm().transpose();
+        }
+        for (Eigen::Index j = 0; j < codes.rows(); ++j)
+        {
+            double d = 0;
+            for (Eigen::Index s = 0; s < codes.cols(); ++s)
+            {
+                d += table(s, codes(j, s));
+            }
+            ret(i, j) = d;
+        }
+    }
+    return ret;
+}
+
+void ProductQuantizer::save(std::ostream& out) const
+{
+    writeValue<uint64_t>(out, _codebooks.size());
+    for (size_t s = 0; s < _codebooks.size(); ++s)
+    {
+        writeValue<uint64_t>(out, _bounds[s + 1]);
+        writeMatrix(out, _codebooks[s]);
+    }
+}
+
+bool ProductQuantizer::load(std::istream& in)
+{
+    uint64_t subspaces;
+    if (!readValue(in, subspaces))
+    {
+        return false;
+    }
+    _bounds.assign(1, 0);
+    _codebooks.resize(subspaces);
+    for (size_t s = 0; s < subspaces; ++s)
+    {
+        uint64_t bound;
+        if (!readValue(in, bound) || !readMatrix(in, _codebooks[s]) || _codebooks[s].rows() > 256
+            || _codebooks[s].cols() != (Eigen::Index)bound - _bounds.back())
+        {
+            return false;
+        }
+        _bounds.push_back(bound);
+    }
+    return true;
+}
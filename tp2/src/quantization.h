@@ -0,0 +1,64 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "types.h"
+
+/*
+Cuantización escalar a 8 bits: x ≈ offset + scale * código, con el mismo offset y escala en todas
+las coordenadas (en las imágenes todos los píxeles comparten rango). Si todos los valores son
+enteros y su rango es a lo sumo 255 (píxeles de 0 a 255) la escala es 1 y la codificación es
+exacta; si no, el rango se divide en 255 pasos.
+*/
+class ScalarQuantizer {
+public:
+
+    ScalarQuantizer();
+
+    void fit(const MatrixRef& X);
+
+    ByteMatrix encode(const MatrixRef& X) const;
+
+    // Distancias al cuadrado entre cada fila de queries (filas) y cada fila de codes (columnas),
+    // acumuladas en enteros (con SSE2 si está disponible) y llevadas a la escala original
+    Matrix distances(const ByteMatrix& queries, const ByteMatrix& codes) const;
+
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+private:
+
+    double _offset;
+    double _scale;
+};
+
+/*
+Product quantization: las columnas se parten en subespacios y en cada uno se cuantiza con
+k-means de a lo sumo 256 centroides, así que cada elemento queda guardado en un byte por subespacio.
+La distancia de una consulta (sin cuantizar) a un código es la suma de las distancias de cada
+subespacio al centroide correspondiente, que se precalculan en una tabla por consulta.
+*/
+class ProductQuantizer {
+public:
+
+    ProductQuantizer();
+
+    void fit(const MatrixRef& X, size_t subspaces, size_t iterations = 10, unsigned int seed = 0);
+
+    ByteMatrix encode(const MatrixRef& X) const;
+
+    // Distancias al cuadrado aproximadas entre cada fila de queries (filas) y cada código (columnas)
+    Matrix distances(const MatrixRef& queries, const ByteMatrix& codes) const;
+
+    size_t subspaces() const;
+
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+private:
+
+    // El subespacio s son las columnas [_bounds[s], _bounds[s+1])
+    std::vector<Eigen::Index> _bounds;
+    std::vector<Matrix> _codebooks;
+};
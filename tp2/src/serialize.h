@@ -0,0 +1,117 @@
+#pragma once
+
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "types.h"
+
+/*
+Lectura y escritura binaria de los modelos. Los valores se guardan tal cual están en memoria,
+así que un archivo solo se puede leer en una máquina con el mismo endianness.
+*/
+
+template<typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(std::istream& in, T& value)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+inline void writeString(std::ostream& out, const std::string& value)
+{
+    writeValue<uint32_t>(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+inline bool readString(std::istream& in, std::string& value)
+{
+    uint32_t size;
+    if (!readValue(in, size))
+    {
+        return false;
+    }
+    value.resize(size);
+    return size == 0 || (bool)in.read(&value[0], size);
+}
+
+// Guarda filas, columnas y los coeficientes en el orden de almacenamiento de la matriz
+template<typename Derived>
+void writeMatrix(std::ostream& out, const Eigen::PlainObjectBase<Derived>& matrix)
+{
+    writeValue<uint64_t>(out, matrix.rows());
+    writeValue<uint64_t>(out, matrix.cols());
+    out.write(reinterpret_cast<const char*>(matrix.data()), matrix.size() * sizeof(typename Derived::Scalar));
+}
+
+template<typename Derived>
+bool readMatrix(std::istream& in, Eigen::PlainObjectBase<Derived>& matrix)
+{
+    uint64_t rows, cols;
+    if (!readValue(in, rows) || !readValue(in, cols))
+    {
+        return false;
+    }
+    matrix.resize(rows, cols);
+    return (bool)in.read(reinterpret_cast<char*>(matrix.data()), matrix.size() * sizeof(typename Derived::Scalar));
+}
+
+// Guarda filas, columnas, cantidad de no nulos y los arreglos de la matriz, que tiene que estar comprimida
+inline void writeSparse(std::ostream& out, const SparseMatrix& matrix)
+{
+    writeValue<uint64_t>(out, matrix.rows());
+    writeValue<uint64_t>(out, matrix.cols());
+    writeValue<uint64_t>(out, matrix.nonZeros());
+    out.write(reinterpret_cast<const char*>(matrix.outerIndexPtr()), (matrix.outerSize() + 1) * sizeof(SparseMatrix::StorageIndex));
+    out.write(reinterpret_cast<const char*>(matrix.innerIndexPtr()), matrix.nonZeros() * sizeof(SparseMatrix::StorageIndex));
+    out.write(reinterpret_cast<const char*>(matrix.valuePtr()), matrix.nonZeros() * sizeof(double));
+}
+
+/*
+Lee lo que guardó writeSparse. Devuelve false si el archivo está cortado o los arreglos no forman
+una matriz comprimida válida: tamaños que no entran en StorageIndex, outer que no arranca en 0, no
+termina en la cantidad de no nulos o decrece, o índices de columna fuera de [0, cols) o no
+crecientes dentro de una fila.
+*/
+inline bool readSparse(std::istream& in, SparseMatrix& matrix)
+{
+    typedef SparseMatrix::StorageIndex Index;
+    const uint64_t maxIndex = std::numeric_limits<Index>::max();
+    uint64_t rows, cols, nonZeros;
+    if (!readValue(in, rows) || !readValue(in, cols) || !readValue(in, nonZeros)
+        || rows >= maxIndex || cols > maxIndex || nonZeros > maxIndex)
+    {
+        return false;
+    }
+    std::vector<Index> outer(rows + 1), inner(nonZeros);
+    std::vector<double> values(nonZeros);
+    if (!in.read(reinterpret_cast<char*>(outer.data()), outer.size() * sizeof(Index))
+        || !in.read(reinterpret_cast<char*>(inner.data()), inner.size() * sizeof(Index))
+        || !in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double))
+        || outer.front() != 0 || (uint64_t)outer.back() != nonZeros)
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < rows; ++i)
+    {
+        if (outer[i + 1] < outer[i] || (uint64_t)outer[i + 1] > nonZeros)
+        {
+            return false;
+        }
+        for (Index j = outer[i]; j < outer[i + 1]; ++j)
+        {
+            if (inner[j] < 0 || (uint64_t)inner[j] >= cols || (j > outer[i] && inner[j] <= inner[j - 1]))
+            {
+                return false;
+            }
+        }
+    }
+    matrix = Eigen::Map<const SparseMatrix>(rows, cols, nonZeros, outer.data(), inner.data(), values.data());
+    return true;
+}
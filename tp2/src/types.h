@@ -2,12 +2,26 @@
 
 #include <Eigen/Sparse>
 #include <Eigen/Dense>
+#include <cstdint>
 
 using Eigen::MatrixXd;
 
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
-typedef Eigen::SparseMatrix<double> SparseMatrix;
+// Vista de solo lectura sobre una Matrix, un bloque de filas o un arreglo de NumPy float64
+// con filas contiguas; pybind11 la arma sin copiar el arreglo
+typedef Eigen::Ref<const Matrix> MatrixRef;
+// Por filas (CSR), como scipy.sparse.csr_matrix, que es lo que pybind11 convierte a este tipo
+typedef Eigen::SparseMatrix<double, Eigen::RowMajor> SparseMatrix;
 
 typedef Eigen::Matrix<size_t, Eigen::Dynamic, 1> IntVector;
+// Una fila por consulta, una columna por cada k pedido
+typedef Eigen::Matrix<size_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> IntMatrix;
 typedef Eigen::VectorXd Vector;
 typedef Eigen::RowVectorXd RowVector;
+
+// Índices de vecinos y sus distancias, una fila por consulta
+typedef Eigen::Matrix<uint32_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> IndexMatrix;
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> FloatMatrix;
+
+// Datos cuantizados a 8 bits, una fila por elemento
+typedef Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ByteMatrix;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iostream>
+#include <stdexcept>
+
+/*
+Chequeos mínimos para los tests de regresión: CHECK informa la condición que falló y sigue, y el
+main de cada test devuelve failures() para que ctest lo marque como fallido.
+*/
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(condition)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(condition))                                                                       \
+        {                                                                                       \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": falló " << #condition << std::endl; \
+            ++failures();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+// Si f tira std::invalid_argument, que es lo que pybind11 convierte en ValueError
+template <typename F>
+bool throws(F f)
+{
+    try
+    {
+        f();
+    }
+    catch (const std::invalid_argument&)
+    {
+        return true;
+    }
+    return false;
+}
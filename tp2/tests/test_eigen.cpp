@@ -0,0 +1,159 @@
+#include <cstdio>
+#include <random>
+#include <Eigen/Eigenvalues>
+#include "check.h"
+#include "eigen.h"
+#include "parallel.h"
+#include "pca.h"
+
+// Datos con varianzas que decrecen por columna, para que los autovalores de la covarianza estén separados
+static Matrix make_data(Eigen::Index rows, Eigen::Index cols, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> normal;
+    Matrix X(rows, cols);
+    for (Eigen::Index i = 0; i < rows; ++i)
+    {
+        for (Eigen::Index j = 0; j < cols; ++j)
+        {
+            X(i, j) = normal(generator) * (cols - j);
+        }
+    }
+    return X;
+}
+
+static Matrix centered_covariance(const Matrix& X)
+{
+    Matrix centered = X.rowwise() - X.colwise().mean();
+    return centered.transpose() * centered / double(X.rows() - 1);
+}
+
+// Cada solver encuentra los autopares dominantes: residuo chico y mismos autovalores que Eigen
+static void test_solvers()
+{
+    Matrix cov = centered_covariance(make_data(400, 30, 1));
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> reference(cov);
+    const unsigned num = 5;
+    Vector expected = reference.eigenvalues().reverse().head(num);
+
+    for (std::string method : {"power", "subspace", "lanczos"})
+    {
+        EigenResult result = eigen_solve(cov, num, method, method == "power" ? 5000 : 1000, 1e-10);
+        CHECK(result.eigenvalues.size() == num && result.eigenvectors.cols() == num);
+        CHECK((result.eigenvalues - expected).cwiseAbs().maxCoeff() <= 1e-6 * expected(0));
+        for (unsigned i = 0; i < num; ++i)
+        {
+            Vector v = result.eigenvectors.col(i);
+            CHECK((cov * v - result.eigenvalues(i) * v).norm() <= 1e-6 * expected(0));
+            CHECK(result.residuals(i) <= 1e-6 * expected(0));
+        }
+
+        // Arrancando desde sus propios autovectores converge igual, sin más productos
+        EigenResult warm = eigen_solve(cov, num, method, method == "power" ? 5000 : 1000, 1e-10, result.eigenvectors);
+        CHECK((warm.eigenvalues - expected).cwiseAbs().maxCoeff() <= 1e-6 * expected(0));
+        CHECK(warm.products <= result.products);
+    }
+
+    // Un método desconocido no cae en subspace
+    CHECK(throws([&] { eigen_solve(cov, num, "lanczsos"); }));
+}
+
+// Con la misma semilla el método de la potencia da exactamente lo mismo, con cualquier cantidad de threads
+static void test_power_iteration()
+{
+    Matrix cov = covariance(make_data(400, 300, 6));
+    std::pair<double, Vector> first = power_iteration(cov, 5000, 1e-12, 7);
+    CHECK((cov * first.second - first.first * first.second).norm() <= 1e-5 * first.first);
+
+    set_num_threads(4);
+    std::pair<double, Vector> second = power_iteration(cov, 5000, 1e-12, 7);
+    set_num_threads(1);
+    CHECK(first.first == second.first && first.second == second.second);
+}
+
+// Las componentes de PCA generan el mismo subespacio con cualquier solver (también con datos ralos),
+// y la proyección queda centrada
+static void test_pca()
+{
+    Matrix X = make_data(500, 20, 2);
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> reference(centered_covariance(X));
+    Matrix expected = reference.eigenvectors().rightCols(4);
+
+    for (std::string solver : {"subspace", "lanczos", "power", "randomized"})
+    {
+        PCA pca(4, solver, 10, 4);
+        pca.fit(X);
+        // Los valores singulares de la proyección son los cosenos de los ángulos entre los subespacios
+        Eigen::JacobiSVD<Eigen::MatrixXd> angles(expected.transpose() * pca.components());
+        CHECK(angles.singularValues().minCoeff() >= 1.0 - 1e-6);
+
+        Matrix projected = pca.transform(X);
+        CHECK(projected.colwise().mean().cwiseAbs().maxCoeff() <= 1e-8);
+        CHECK((pca.transformBeta(X, 2) - projected.leftCols(2)).cwiseAbs().maxCoeff() <= 1e-10);
+    }
+
+    // Un solver mal escrito no cae en subspace
+    CHECK(throws([] { PCA pca(4, "lanczsos"); }));
+
+    // Con la mitad de los coeficientes en cero, ajustar sobre la matriz rala da las mismas proyecciones
+    Matrix positive = X.cwiseMax(0.0);
+    SparseMatrix sparse = positive.sparseView();
+    CHECK((covariance(sparse) - covariance(positive)).cwiseAbs().maxCoeff() <= 1e-8);
+    PCA dense(4), sparsePca(4);
+    dense.fit(positive);
+    sparsePca.fitSparse(sparse);
+    CHECK((dense.transform(positive).cwiseAbs() - sparsePca.transformSparse(sparse).cwiseAbs()).cwiseAbs().maxCoeff() <= 1e-6);
+}
+
+// partial_fit de a lotes llega al mismo subespacio que fit con todos los datos cuando hay una brecha
+// entre las primeras componentes y el resto (sin brecha la actualización por lotes es aproximada)
+static void test_incremental_pca()
+{
+    Matrix X = make_data(2000, 20, 3);
+    X.rightCols(16) *= 0.1;
+    PCA full(4), incremental(4);
+    full.fit(X);
+    for (Eigen::Index begin = 0; begin < X.rows(); begin += 100)
+    {
+        incremental.partial_fit(X.middleRows(begin, 100));
+    }
+    Eigen::JacobiSVD<Eigen::MatrixXd> angles(full.components().transpose() * incremental.components());
+    CHECK(angles.singularValues().minCoeff() >= 1.0 - 1e-6);
+}
+
+// covariance sin copiar los datos centrados da lo mismo que centrar y multiplicar
+static void test_covariance()
+{
+    Matrix X = make_data(300, 25, 4);
+    X.array() += 100.0;
+    CHECK((covariance(X) - centered_covariance(X)).cwiseAbs().maxCoeff() <= 1e-10 * centered_covariance(X).cwiseAbs().maxCoeff());
+}
+
+// Un PCA cargado de disco proyecta igual que el original, y con warm_start sigue desde ahí
+static void test_pca_save_load()
+{
+    const char* path = "test_eigen.pca";
+    Matrix X = make_data(300, 15, 5);
+    PCA pca(4);
+    pca.fit(X);
+    CHECK(pca.save(path));
+
+    PCA loaded(1, "subspace", 10, 2, true);
+    CHECK(loaded.load(path));
+    CHECK((loaded.transform(X) - pca.transform(X)).cwiseAbs().maxCoeff() == 0.0);
+    loaded.fit(X);
+    CHECK(loaded.products() <= pca.products());
+    CHECK((loaded.transform(X).cwiseAbs() - pca.transform(X).cwiseAbs()).cwiseAbs().maxCoeff() <= 1e-6);
+    std::remove(path);
+}
+
+int main()
+{
+    test_covariance();
+    test_solvers();
+    test_power_iteration();
+    test_pca();
+    test_incremental_pca();
+    test_pca_save_load();
+    return failures();
+}
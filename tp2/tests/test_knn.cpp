@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "check.h"
+#include "crossval.h"
+#include "kdtree.h"
+#include "knn.h"
+#include "pipeline.h"
+#include "quantization.h"
+#include "serialize.h"
+
+// Datos con 10 clases alrededor de centros al azar, como en las imágenes: los vecinos no empatan
+static void make_data(Eigen::Index rows, Eigen::Index cols, unsigned int seed, Matrix& X, IntVector& y)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> normal;
+    Matrix centers(10, cols);
+    for (Eigen::Index i = 0; i < centers.size(); ++i)
+    {
+        centers.data()[i] = 3.0 * normal(generator);
+    }
+    X.resize(rows, cols);
+    y.resize(rows);
+    for (Eigen::Index i = 0; i < rows; ++i)
+    {
+        y(i) = generator() % 10;
+        for (Eigen::Index j = 0; j < cols; ++j)
+        {
+            X(i, j) = centers(y(i), j) + normal(generator);
+        }
+    }
+}
+
+// Los k vecinos de cada consulta ordenando todas las distancias (a igual distancia, menor índice)
+static IndexMatrix exact_neighbors(const Matrix& X, const Matrix& queries, size_t k)
+{
+    IndexMatrix ret(queries.rows(), k);
+    for (Eigen::Index q = 0; q < queries.rows(); ++q)
+    {
+        Vector dist = (X.rowwise() - queries.row(q)).rowwise().squaredNorm();
+        std::vector<uint32_t> order(X.rows());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&dist](uint32_t a, uint32_t b) { return dist(a) < dist(b); });
+        for (size_t i = 0; i < k; ++i)
+        {
+            ret(q, i) = order[i];
+        }
+    }
+    return ret;
+}
+
+static IndexMatrix neighbors_of(KNNClassifier& knn, const Matrix& X, const IntVector& y, const Matrix& queries)
+{
+    knn.fit(X, y);
+    knn.predict(queries);
+    return knn.neighbors();
+}
+
+// Todos los algoritmos exactos (y el IVF recorriendo todas las listas) dan los mismos vecinos que ordenar
+static void test_exact_neighbors()
+{
+    const size_t k = 10;
+    for (Eigen::Index cols : {8, 40})
+    {
+        Matrix X, queries;
+        IntVector y, yQueries;
+        make_data(1500, cols, 1, X, y);
+        make_data(200, cols, 2, queries, yQueries);
+        IndexMatrix expected = exact_neighbors(X, queries, k);
+
+        KNNClassifier brute(1, k, "brute");
+        CHECK(neighbors_of(brute, X, y, queries) == expected);
+
+        KNNClassifier tree(1, k, "kd_tree");
+        CHECK(neighbors_of(tree, X, y, queries) == expected);
+        CHECK(tree.algorithm() == "kd_tree");
+
+        KNNClassifier ivf(1, k, "ivf", 16, 16);
+        CHECK(neighbors_of(ivf, X, y, queries) == expected);
+        CHECK(ivf.algorithm() == "ivf");
+
+        KNNClassifier single(1, k, "brute", 0, 8, "float");
+        CHECK(neighbors_of(single, X, y, queries) == expected);
+
+        // Entradas ralas (la mitad de los coeficientes en cero), entrenando ralo o denso
+        Matrix positiveX = X.cwiseMax(0.0), positiveQueries = queries.cwiseMax(0.0);
+        IndexMatrix expectedPositive = exact_neighbors(positiveX, positiveQueries, k);
+        SparseMatrix sparseX = positiveX.sparseView();
+        SparseMatrix sparseQueries = positiveQueries.sparseView();
+        KNNClassifier sparse(1, k);
+        sparse.fitSparse(sparseX, y);
+        sparse.predictSparse(sparseQueries);
+        CHECK(sparse.neighbors() == expectedPositive);
+        CHECK(neighbors_of(brute, positiveX, y, positiveQueries) == expectedPositive);
+        brute.predictSparse(sparseQueries);
+        CHECK(brute.neighbors() == expectedPositive);
+    }
+}
+
+// Sin filas de entrenamiento no se construye ningún índice y predict devuelve un vector vacío
+static void test_empty_training()
+{
+    for (std::string algorithm : {"brute", "kd_tree", "ivf", "auto"})
+    {
+        KNNClassifier knn(1, 1, algorithm);
+        knn.fit(Matrix(0, 4), IntVector(0));
+        CHECK(knn.predict(Matrix::Ones(3, 4)).size() == 0);
+        CHECK(knn.predictWithK(1).size() == 0);
+    }
+
+    KDTree tree;
+    tree.build(Matrix(0, 4));
+    CHECK(tree.empty());
+}
+
+// readSparse lee lo que escribe writeSparse y rechaza arreglos que no forman una matriz comprimida
+static void test_read_sparse()
+{
+    Matrix dense(3, 4);
+    dense << 1, 0, 2, 0,
+             0, 0, 0, 0,
+             0, 3, 0, 4;
+    SparseMatrix matrix = dense.sparseView();
+    matrix.makeCompressed();
+    std::ostringstream out;
+    writeSparse(out, matrix);
+    const std::string bytes = out.str();
+
+    SparseMatrix read;
+    std::istringstream in(bytes);
+    CHECK(readSparse(in, read) && Matrix(read) == dense);
+
+    // Reemplaza el StorageIndex en la posición index de los arreglos (outer y después inner)
+    auto corrupt = [&](size_t index, SparseMatrix::StorageIndex value) {
+        std::string modified = bytes;
+        std::memcpy(&modified[3 * sizeof(uint64_t) + index * sizeof(value)], &value, sizeof(value));
+        std::istringstream in(modified);
+        SparseMatrix read;
+        return readSparse(in, read);
+    };
+    // outer es 0 2 2 4 y inner 0 2 1 3
+    CHECK(!corrupt(1, 3));
+    CHECK(!corrupt(2, 1));
+    CHECK(!corrupt(4 + 1, 4));
+    CHECK(!corrupt(4 + 2, -1));
+    CHECK(!corrupt(4 + 1, 0));
+    CHECK(corrupt(4 + 3, 2));
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 1));
+    CHECK(!readSparse(truncated, read));
+}
+
+// Un algoritmo, storage o weights desconocido no cae en el valor por defecto
+static void test_unknown_algorithm()
+{
+    CHECK(throws([] { KNNClassifier knn(1, 1, "kdtree"); }));
+    CHECK(!throws([] { KNNClassifier knn(1, 1, "kd_tree"); }));
+    CHECK(throws([] { KNNClassifier knn(1, 1, "brute", 0, 1, "int8"); }));
+    CHECK(throws([] { KNNClassifier knn(1, 1, "brute", 0, 1, "double", 0, "distances"); }));
+}
+
+// cross_validate no arma folds sin datos: con menos de dos filas, folds fuera de [2, filas],
+// etiquetas de más o de menos o un beta o k en 0 tira, y un fold sin entrenamiento suficiente queda en NaN
+static void test_cross_validate_edges()
+{
+    IntVector betas(1), ks(1);
+    betas << 2;
+    ks << 1;
+    CHECK(throws([&] { cross_validate(Matrix::Ones(1, 4), IntVector::Zero(1), 5, betas, ks); }));
+    CHECK(throws([&] { cross_validate(Matrix::Ones(3, 4), IntVector::Zero(3), 5, betas, ks); }));
+    CHECK(throws([&] { cross_validate(Matrix::Ones(3, 4), IntVector::Zero(3), 1, betas, ks); }));
+    CHECK(throws([&] { cross_validate(Matrix::Ones(3, 4), IntVector::Zero(2), 2, betas, ks); }));
+    CHECK(throws([&] { cross_validate(Matrix::Ones(3, 4), IntVector::Zero(3), 2, IntVector::Zero(1), ks); }));
+    CHECK(throws([&] { cross_validate(Matrix::Ones(3, 4), IntVector::Zero(3), 2, betas, IntVector::Zero(1)); }));
+    Matrix accuracy = cross_validate(Matrix::Random(2, 4), IntVector::Zero(2), 2, betas, ks);
+    CHECK(accuracy.rows() == 2 && std::isnan(accuracy(0, 0)));
+}
+
+// Un vecino cercano de la etiqueta 1 contra dos lejanos de la 2: por cantidad gana la 2, pesando
+// por distancia gana la 1, y con un voto de cada una gana la del más cercano
+static void test_votes()
+{
+    Matrix X(3, 1), query(1, 1);
+    X << 0.1, 1.0, 1.1;
+    query << 0.0;
+    IntVector y(3);
+    y << 1, 2, 2;
+
+    KNNClassifier uniform(3, 0, "brute"), weighted(3, 0, "brute", 0, 8, "double", 0, "distance");
+    uniform.fit(X, y);
+    weighted.fit(X, y);
+    CHECK(uniform.predict(query)(0) == 2);
+    CHECK(weighted.predict(query)(0) == 1);
+    CHECK(uniform.predictWithK(2)(0) == 1);
+}
+
+// El pipeline predice lo mismo que proyectar con su PCA y pasarle el resultado a un KNN aparte
+static void test_pipeline()
+{
+    Matrix X, queries;
+    IntVector y, yQueries;
+    make_data(1000, 30, 6, X, y);
+    make_data(200, 30, 7, queries, yQueries);
+
+    PCAKNNPipeline pipeline(8, 3, 10, "brute");
+    pipeline.fit(X, y);
+    IntVector predicted = pipeline.predict(queries);
+
+    PCA pca = pipeline.pca();
+    KNNClassifier knn(3, 10, "brute");
+    knn.fit(pca.transform(X), y);
+    CHECK(predicted == knn.predict(pca.transform(queries)));
+    CHECK(pipeline.predictWithK(10) == knn.predictWithK(10));
+}
+
+// Sin mezclar, cada fila de cross_validate es la accuracy de ajustar PCA y KNN en ese fold por separado
+static void test_cross_validate()
+{
+    Matrix X;
+    IntVector y;
+    make_data(300, 12, 8, X, y);
+    IntVector betas(2), ks(3);
+    betas << 2, 4;
+    ks << 1, 4, 7;
+    const unsigned int folds = 3;
+    Matrix accuracy = cross_validate(X, y, folds, betas, ks, false);
+    CHECK(accuracy.rows() == folds * betas.size() && accuracy.cols() == ks.size());
+
+    for (unsigned int fold = 0; fold < folds && accuracy.rows() == folds * betas.size(); ++fold)
+    {
+        Eigen::Index first = fold * X.rows() / folds;
+        Eigen::Index testRows = (fold + 1) * X.rows() / folds - first;
+        Matrix train(X.rows() - testRows, X.cols());
+        IntVector yTrain(train.rows());
+        train << X.topRows(first), X.bottomRows(X.rows() - first - testRows);
+        yTrain << y.head(first), y.tail(X.rows() - first - testRows);
+        Matrix test = X.middleRows(first, testRows);
+        IntVector yTest = y.segment(first, testRows);
+
+        for (Eigen::Index b = 0; b < betas.size(); ++b)
+        {
+            PCA pca(betas(b));
+            pca.fit(train);
+            KNNClassifier knn(1, ks.maxCoeff());
+            knn.fit(pca.transform(train), yTrain);
+            knn.predict(pca.transform(test));
+            for (Eigen::Index c = 0; c < ks.size(); ++c)
+            {
+                double hits = (knn.predictWithK(ks(c)).array() == yTest.array()).count();
+                CHECK(std::abs(accuracy(fold * betas.size() + b, c) - hits / testRows) <= 1e-12);
+            }
+        }
+    }
+}
+
+static void test_scalar_quantizer()
+{
+    // Enteros en [0, 255]: escala 1, así que las distancias son exactas (también fuera de los múltiplos de 16)
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> pixel(0, 255);
+    for (Eigen::Index cols : {1, 15, 16, 17, 100})
+    {
+        Matrix X(30, cols);
+        for (Eigen::Index i = 0; i < X.size(); ++i)
+        {
+            X.data()[i] = pixel(generator);
+        }
+        ScalarQuantizer quantizer;
+        quantizer.fit(X);
+        ByteMatrix codes = quantizer.encode(X);
+        Matrix dist = quantizer.distances(codes.topRows(5), codes);
+        for (Eigen::Index i = 0; i < 5; ++i)
+        {
+            CHECK((dist.row(i).transpose() - (X.rowwise() - X.row(i)).rowwise().squaredNorm()).cwiseAbs().maxCoeff() == 0.0);
+        }
+    }
+
+    // Datos en [0, 1]: no se pueden redondear a enteros, el error tiene que ser de medio paso
+    Matrix unit = (Matrix::Random(200, 30).array() + 1.0) / 2.0;
+    ScalarQuantizer quantizer;
+    quantizer.fit(unit);
+    double step = (unit.maxCoeff() - unit.minCoeff()) / 255.0;
+    Matrix decoded = (quantizer.encode(unit).cast<double>() * step).array() + unit.minCoeff();
+    CHECK((decoded - unit).cwiseAbs().maxCoeff() <= step / 2 + 1e-12);
+
+    // Y con esos datos uint8 predice casi lo mismo que double
+    Matrix X, queries;
+    IntVector y, yQueries;
+    make_data(1000, 20, 4, X, y);
+    make_data(300, 20, 5, queries, yQueries);
+    Matrix scaledX = (X.array() - X.minCoeff()) / (X.maxCoeff() - X.minCoeff());
+    Matrix scaledQueries = (queries.array() - X.minCoeff()) / (X.maxCoeff() - X.minCoeff());
+    KNNClassifier exact(3), bytes(3, 0, "brute", 0, 8, "uint8");
+    exact.fit(scaledX, y);
+    bytes.fit(scaledX, y);
+    IntVector a = exact.predict(scaledQueries), b = bytes.predict(scaledQueries);
+    CHECK((a.array() != b.array()).count() <= 3);
+}
+
+int main()
+{
+    test_exact_neighbors();
+    test_empty_training();
+    test_unknown_algorithm();
+    test_read_sparse();
+    test_votes();
+    test_pipeline();
+    test_cross_validate();
+    test_cross_validate_edges();
+    test_scalar_quantizer();
+    return failures();
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "check.h"
+#include "loader.h"
+
+static const char* PATH = "test_loader.bin";
+static const char* CSV_PATH = "test_loader.csv";
+
+static Matrix read_all(BatchReader& reader)
+{
+    Matrix rows(0, reader.columns());
+    for (Matrix batch = reader.next(); batch.rows() > 0; batch = reader.next())
+    {
+        rows.conservativeResize(rows.rows() + batch.rows(), reader.columns());
+        rows.bottomRows(batch.rows()) = batch;
+    }
+    return rows;
+}
+
+// Lo escrito con write_binary se lee igual mapeado y de a lotes, y los coeficientes quedan alineados
+static void test_round_trip()
+{
+    Matrix X = Matrix::Random(37, 5);
+    CHECK(write_binary(PATH, X));
+
+    MappedMatrix mapped(PATH);
+    CHECK(mapped.good());
+    CHECK(mapped.matrix() == X);
+    CHECK(reinterpret_cast<uintptr_t>(mapped.matrix().data()) % alignof(double) == 0);
+
+    BatchReader reader(PATH, 10, 1);
+    CHECK(reader.good() && reader.columns() == 4);
+    CHECK(read_all(reader) == X.rightCols(4));
+}
+
+// Un CSV con encabezado se lee salteando el encabezado y las columnas pedidas
+static void test_csv()
+{
+    std::ofstream out(CSV_PATH);
+    out << "label,a,b\n1,0.5,2\n0,3,-1.25\n7,4e2,0\n";
+    out.close();
+
+    Matrix expected(3, 2);
+    expected << 0.5, 2, 3, -1.25, 400, 0;
+    BatchReader reader(CSV_PATH, 2, 1);
+    CHECK(reader.good() && reader.columns() == 2);
+    CHECK(read_all(reader) == expected);
+}
+
+// Mensaje del error al leer un CSV con ese contenido, vacío si se lee entero
+static std::string csv_error(const std::string& content)
+{
+    std::ofstream out(CSV_PATH);
+    out << content;
+    out.close();
+    try
+    {
+        BatchReader reader(CSV_PATH, 2, 1);
+        read_all(reader);
+    }
+    catch (const std::runtime_error& error)
+    {
+        return error.what();
+    }
+    return "";
+}
+
+// Una fila mal formada no se descarta: el error dice en qué línea está. Las líneas vacías se saltean
+static void test_malformed_csv()
+{
+    CHECK(csv_error("label,a,b\n1,0.5,2\n\n0,3,-1.25\r\n\n").empty());
+    CHECK(csv_error("label,a,b\n1,0.5,2\n\n0,3\n7,4e2,0\n").find("línea 4 ") != std::string::npos);
+    CHECK(csv_error("label,a,b\n1,0.5,2\n0,x,-1.25\n").find("línea 3 ") != std::string::npos);
+    CHECK(csv_error("label,a,b\n1,0.5,2\n0,3,-1.25,8\n").find("línea 3 ") != std::string::npos);
+}
+
+int main()
+{
+    test_round_trip();
+    test_csv();
+    test_malformed_csv();
+    std::remove(PATH);
+    std::remove(CSV_PATH);
+    return failures();
+}
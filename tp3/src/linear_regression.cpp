@@ -12,24 +12,35 @@ LinearRegression::LinearRegression()
 {
 }
 
-void LinearRegression::fit(Matrix X, Matrix y)
+/**
+* Cuadrados mínimos con la matriz [X 1]: las ecuaciones normales se arman por bloques,
+* [X^T X, X^T 1; 1^T X, n] c = [X^T y; 1^T y], así que no hace falta una copia de X con la
+* columna de unos.
+*/
+void LinearRegression::fit(const MatrixRef& X, const MatrixRef& y)
 {
-    X.conservativeResize(X.rows(), X.cols()+1);
-    X.col(X.cols()-1) = MatrixXd::Ones(X.rows(), 1);
+    Eigen::Index n = X.rows();
+    Eigen::Index d = X.cols();
 
-    Matrix A = X.transpose()*X;
-    Matrix b = X.transpose()*y;
+    Matrix A(d + 1, d + 1);
+    A.topLeftCorner(d, d).noalias() = X.transpose() * X;
+    A.topRightCorner(d, 1) = X.colwise().sum().transpose();
+    A.bottomLeftCorner(1, d) = X.colwise().sum();
+    A(d, d) = double(n);
+
+    Matrix b(d + 1, y.cols());
+    b.topRows(d).noalias() = X.transpose() * y;
+    b.bottomRows(1) = y.colwise().sum();
 
     coef = A.householderQr().solve(b);
 }
 
 
-Matrix LinearRegression::predict(Matrix X)
+Matrix LinearRegression::predict(const MatrixRef& X)
 {
-    X.conservativeResize(X.rows(), X.cols()+1);
-    X.col(X.cols()-1) = MatrixXd::Ones(X.rows(), 1);
-
-    auto ret = X*coef;
+    Eigen::Index d = X.cols();
+    Matrix ret = X * coef.topRows(d);
+    ret.rowwise() += coef.row(d);
 
     return ret;
 }
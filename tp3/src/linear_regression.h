@@ -6,9 +6,10 @@ class LinearRegression {
 public:
     LinearRegression();
 
-    void fit(Matrix X, Matrix y);
+    // X e y se leen sin copiarlos: la columna de unos del término independiente no se agrega a X
+    void fit(const MatrixRef& X, const MatrixRef& y);
 
-    Matrix predict(Matrix X);
+    Matrix predict(const MatrixRef& X);
 
     Matrix coefs();
 private:
@@ -6,6 +6,8 @@
 using Eigen::MatrixXd;
 
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+// Vista de una matriz (por ejemplo un array de numpy) sin copiarla
+typedef Eigen::Ref<const Matrix> MatrixRef;
 typedef Eigen::SparseMatrix<double> SparseMatrix;
 
 typedef Eigen::VectorXd Vector;